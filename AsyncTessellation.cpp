@@ -0,0 +1,126 @@
+#include "AsyncTessellation.h"
+
+#include <algorithm>	// std::min, std::max
+#include <chrono>		// timing of the levels
+
+#include "Profiler.h"
+
+// the coarsest preview level samples at most every PREVIEW_RESOLUTION in parameter space
+static const float PREVIEW_RESOLUTION = 0.1f;
+
+// rows evaluated between two checks of the cancellation flag
+static const size_t CANCEL_CHECK_ROWS = 4;
+
+// every stride-th parameter and the last one, so all levels share the border of the final grid
+static std::vector<float> subsampleParameters(const std::vector<float>& parameters, const size_t stride)
+{
+	std::vector<float> result;
+	for (size_t i = 0; i < parameters.size(); i += stride) result.push_back(parameters[i]);
+	if (!parameters.empty() && (parameters.size() - 1) % stride != 0) result.push_back(parameters.back());
+	return result;
+}
+
+AsyncTessellator::AsyncTessellator() : running(false), published(nullptr)
+{
+	// construct the scheduler first, so it outlives a global tessellator
+	JobScheduler::global();
+}
+
+AsyncTessellator::~AsyncTessellator()
+{
+	cancel();
+}
+
+void AsyncTessellator::start(const NURBS_Surface& surface, const size_t surfaceIndex, const float resolutionU, const float resolutionV, const TessellationMode mode)
+{
+	cancel();
+	running = true;
+	job.reset(new TaskGroup(JobScheduler::global()));
+	const CancellationToken token = job->cancellationToken();
+	job->run([this, surface, surfaceIndex, resolutionU, resolutionV, mode, token]()
+	{
+		run(surface, surfaceIndex, resolutionU, resolutionV, mode, token);
+	});
+}
+
+void AsyncTessellator::cancel()
+{
+	if (job)
+	{
+		job->cancel();
+		job->wait();
+		job.reset();
+	}
+	running = false;
+	// a level of the cancelled job must not be taken for a later one
+	publish(nullptr);
+}
+
+bool AsyncTessellator::takeResult(std::shared_ptr<const TessellationResult>& result)
+{
+	const TessellationResult* taken = published.exchange(nullptr);
+	if (!taken) return false;
+	result.reset(taken);
+	return true;
+}
+
+bool AsyncTessellator::isBusy()
+{
+	if (running) return true;
+	return published.load() != nullptr;
+}
+
+void AsyncTessellator::publish(const TessellationResult* result)
+{
+	delete published.exchange(result);
+}
+
+void AsyncTessellator::run(const NURBS_Surface& surface, const size_t surfaceIndex, const float resolutionU, const float resolutionV, const TessellationMode mode, const CancellationToken& token)
+{
+	PROFILE_SCOPE("AsyncTessellator::run");
+	if (!canTessellate(surface))
+	{
+		// publish an empty mesh, so the caller does not keep the mesh of the previous surface
+		std::unique_ptr<TessellationResult> result(new TessellationResult());
+		result->surfaceIndex = surfaceIndex;
+		result->numLevels = 1;
+		publish(result.release());
+		running = false;
+		return;
+	}
+	// halve the resolution from the preview level down to the requested one
+	unsigned int numLevels = 1;
+	while (std::max(resolutionU, resolutionV) * float(1 << numLevels) <= PREVIEW_RESOLUTION) numLevels++;
+	const std::vector<float> finalParametersU = gridParameters(resolutionU);
+	const std::vector<float> finalParametersV = gridParameters(resolutionV);
+
+	for (unsigned int level = 0; level < numLevels && !token.isCancelled(); level++)
+	{
+		auto start = std::chrono::high_resolution_clock::now();
+		const size_t stride = size_t(1) << (numLevels - 1 - level);
+		std::unique_ptr<TessellationResult> result(new TessellationResult());
+		result->surfaceIndex = surfaceIndex;
+		result->level = level;
+		result->numLevels = numLevels;
+		result->parametersU = subsampleParameters(finalParametersU, stride);
+		result->parametersV = subsampleParameters(finalParametersV, stride);
+		prepareMesh(result->parametersU, result->parametersV, result->mesh);
+		prepareCurvatureMaps(result->parametersU, result->parametersV, result->curvatureMaps);
+		// check the cancellation token every few rows, so a cancel does not wait for a whole chunk
+		JobScheduler::global().parallelFor(result->parametersU.size(), CANCEL_CHECK_ROWS, [&](size_t rowBegin, size_t rowEnd)
+		{
+			for (size_t row = rowBegin; row < rowEnd && !token.isCancelled(); row += CANCEL_CHECK_ROWS)
+			{
+				const size_t end = std::min(row + CANCEL_CHECK_ROWS, rowEnd);
+				tessellateRows(surface, result->parametersU, result->parametersV, row, end, mode, result->mesh);
+				computeCurvatureRows(surface, result->parametersU, result->parametersV, row, end, result->curvatureMaps);
+			}
+		}, &token);
+		if (token.isCancelled()) break;
+		buildIndexedMesh(result->mesh, result->indexedMesh);
+		result->milliseconds = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+		// replace a level which was not taken yet, only the newest one is of interest
+		publish(result.release());
+	}
+	running = false;
+}
@@ -0,0 +1,79 @@
+#ifndef ASYNC_TESSELLATION_H
+#define ASYNC_TESSELLATION_H
+
+#include <stdlib.h>			// standard library
+#include <atomic>			// std::atomic<>
+#include <memory>			// std::unique_ptr<>, std::shared_ptr<>
+#include <vector>			// std::vector<>
+
+#include "CurvatureAnalysis.h"
+#include "JobScheduler.h"
+#include "MeshOptimization.h"
+#include "NURBS_Surface.h"
+#include "Tessellation.h"
+
+// one finished refinement level of a background tessellation
+struct TessellationResult
+{
+	TessellatedMesh mesh;
+	IndexedMesh indexedMesh;	// welded and cache ordered triangles of mesh, for drawing
+	std::vector<float> parametersU;
+	std::vector<float> parametersV;
+	CurvatureMaps curvatureMaps;
+	size_t surfaceIndex;		// index passed to start()
+	unsigned int level;			// 0 is the coarsest level, numLevels - 1 the requested resolution
+	unsigned int numLevels;
+	double milliseconds;		// time spent on this level
+
+	TessellationResult() : surfaceIndex(0), level(0), numLevels(0), milliseconds(0.0)
+	{
+	}
+};
+
+// tessellates a surface as a background task of the global job scheduler. starts with a coarse preview and refines it by halving the
+// resolution until the requested one is reached. every finished level is published and can be fetched with
+// takeResult(), so the caller keeps drawing its last complete mesh until a new level is swapped in. the levels are handed
+// over through an atomic pointer which both sides only exchange, neither the job nor the caller takes a lock.
+class AsyncTessellator
+{
+
+public:
+
+	AsyncTessellator();
+
+	// cancels the running job
+	~AsyncTessellator();
+
+	// cancel the running job (if any) and start tessellating a copy of the surface
+	void start(const NURBS_Surface& surface, const size_t surfaceIndex, const float resolutionU, const float resolutionV, const TessellationMode mode);
+
+	// cooperatively cancel the running job and wait for it. a published level which was not taken yet is dropped.
+	void cancel();
+
+	// move the newest published level into result. returns false if nothing was published since the last call.
+	bool takeResult(std::shared_ptr<const TessellationResult>& result);
+
+	// true while the job has levels left to compute or a published level was not taken yet
+	bool isBusy();
+
+private:
+
+	AsyncTessellator(const AsyncTessellator&);
+	AsyncTessellator& operator=(const AsyncTessellator&);
+
+	// make result (owned by the caller) the published level. an older level which was not taken yet is deleted.
+	void publish(const TessellationResult* result);
+
+	// body of the background task
+	void run(const NURBS_Surface& surface, const size_t surfaceIndex, const float resolutionU, const float resolutionV, const TessellationMode mode, const CancellationToken& token);
+
+	std::unique_ptr<TaskGroup> job;		// group of the background task, its token cancels the job
+	std::atomic<bool> running;
+	// the published level, owned by the slot until an exchange moves it out. nobody reads through the pointer while it is in
+	// the slot, so a plain exchange hands it over without reference counting (std::atomic_load on a shared_ptr takes a lock
+	// in libstdc++).
+	std::atomic<const TessellationResult*> published;
+
+};
+
+#endif // ASYNC_TESSELLATION_H
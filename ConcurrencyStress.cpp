@@ -0,0 +1,88 @@
+#include "ConcurrencyStress.h"
+
+#include <atomic>		// std::atomic
+#include <chrono>		// timing
+#include <thread>		// std::thread
+#include <vector>		// std::vector<>
+
+#include "NURBS_PowerBasis.h"
+#include "Tessellation.h"
+
+// results compared per sample: point, tangents, iso curve point and power basis point of the surface
+static const size_t VALUES_PER_SAMPLE = 5;
+
+// partial derivatives up to order 2 per sample
+static const size_t DERIVATIVES_PER_SAMPLE = 9;
+
+ConcurrencyStressResult runConcurrencyStress(const NURBS_Surface& surface, const unsigned int numThreads, const unsigned int iterations)
+{
+	ConcurrencyStressResult result;
+	if (!surface.isValidNURBS()) return result;
+	std::vector<float> stressU = gridParameters(0.05f);
+	std::vector<float> stressV = gridParameters(0.05f);
+	const size_t numSamples = stressU.size() * stressV.size();
+	// one curve shared by all threads as well, and an equal one for the reference (copies would share the caches)
+	const NURBSCurve isoCurve = surface.extractIsoCurveU(0.5f);
+	const NURBSCurve referenceCurve = surface.extractIsoCurveU(0.5f);
+	// one tolerance per iteration, so threads in different iterations replace the cached polyline of isoCurve
+	const float polylineTolerances[2] = { 0.01f, 0.001f };
+	const std::vector<Vec4f> referencePolylines[2] = { referenceCurve.getPolyline(polylineTolerances[0])->points, referenceCurve.getPolyline(polylineTolerances[1])->points };
+	const float arcLength = referenceCurve.getArcLength();
+
+	// single threaded reference, before any thread has built the power basis, the arc length table or a polyline
+	std::vector<Vec4f> reference(numSamples * VALUES_PER_SAMPLE);
+	std::vector<float> referenceArcParameters(numSamples);
+	std::vector<Vec3f> referenceDerivatives(numSamples * DERIVATIVES_PER_SAMPLE);
+	const SurfacePowerBasis referencePowerBasis(surface);
+	for (size_t n = 0; n < numSamples; n++)
+	{
+		const float u = stressU[n / stressV.size()];
+		const float v = stressV[n % stressV.size()];
+		Vec4f* values = &reference[VALUES_PER_SAMPLE * n];
+		values[0] = surface.evaluteDeBoor(u, v, values[1], values[2]);
+		values[3] = isoCurve.evaluteDeBoor(v);
+		Vec4f derivativeU, derivativeV;
+		values[4] = referencePowerBasis.evaluate(u, v, derivativeU, derivativeV);
+		surface.evaluateDerivatives(u, v, 2, &referenceDerivatives[DERIVATIVES_PER_SAMPLE * n]);
+		referenceArcParameters[n] = referenceCurve.parameterAtArcLength(v * arcLength);
+	}
+
+	std::atomic<size_t> mismatches(0);
+	auto start = std::chrono::high_resolution_clock::now();
+	std::vector<std::thread> threads;
+	for (unsigned int t = 0; t < numThreads; t++) threads.emplace_back([&, t]()
+	{
+		Vec3f derivatives[DERIVATIVES_PER_SAMPLE];
+		for (unsigned int iteration = 0; iteration < iterations; iteration++)
+		{
+			// every thread starts somewhere else, so the threads read the same data at different times
+			for (size_t m = 0; m < numSamples; m++)
+			{
+				const size_t n = (m + t * numSamples / numThreads) % numSamples;
+				const float u = stressU[n / stressV.size()];
+				const float v = stressV[n % stressV.size()];
+				const Vec4f* values = &reference[VALUES_PER_SAMPLE * n];
+				Vec4f tangentU, tangentV;
+				Vec4f point = surface.evaluteDeBoor(u, v, tangentU, tangentV);
+				Vec4f curvePoint = isoCurve.evaluteDeBoor(v);
+				// the threads race to build the shared power basis
+				Vec4f derivativeU, derivativeV;
+				Vec4f powerBasisPoint = surface.getPowerBasis()->evaluate(u, v, derivativeU, derivativeV);
+				surface.evaluateDerivatives(u, v, 2, derivatives);
+				// and the cached arc length table and polyline of the curve
+				float arcParameter = isoCurve.parameterAtArcLength(v * arcLength);
+				std::shared_ptr<const CurvePolyline> polyline = isoCurve.getPolyline(polylineTolerances[iteration % 2]);
+				bool equal = point == values[0] && tangentU == values[1] && tangentV == values[2] && curvePoint == values[3] && powerBasisPoint == values[4];
+				equal = equal && arcParameter == referenceArcParameters[n] && polyline->points == referencePolylines[iteration % 2];
+				for (size_t k = 0; k < DERIVATIVES_PER_SAMPLE; k++) equal = equal && derivatives[k] == referenceDerivatives[DERIVATIVES_PER_SAMPLE * n + k];
+				if (!equal) mismatches++;
+			}
+		}
+	});
+	for (std::thread& thread : threads) thread.join();
+	result.milliseconds = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+	result.numThreads = numThreads;
+	result.samplesPerThread = iterations * numSamples;
+	result.mismatches = mismatches;
+	return result;
+}
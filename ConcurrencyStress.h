@@ -0,0 +1,26 @@
+#ifndef CONCURRENCY_STRESS_H
+#define CONCURRENCY_STRESS_H
+
+#include <stdlib.h>			// standard library
+
+#include "NURBS_Surface.h"
+
+// outcome of runConcurrencyStress
+struct ConcurrencyStressResult
+{
+	unsigned int numThreads;
+	size_t samplesPerThread;
+	size_t mismatches;		// samples of any thread which differ from the single threaded reference
+	double milliseconds;
+
+	ConcurrencyStressResult() : numThreads(0), samplesPerThread(0), mismatches(0), milliseconds(0.0)
+	{
+	}
+};
+
+// evaluate surface (points, tangents, derivatives up to order 2, power basis and an iso curve with its arc length table
+// and polyline) from numThreads threads at once, iterations times over a grid, and compare every result with a single
+// threaded reference. build with ENABLE_THREAD_SANITIZER to check for data races. an invalid surface is not evaluated.
+ConcurrencyStressResult runConcurrencyStress(const NURBS_Surface& surface, const unsigned int numThreads, const unsigned int iterations);
+
+#endif // CONCURRENCY_STRESS_H
@@ -0,0 +1,120 @@
+#include "CurvatureAnalysis.h"
+
+#include <algorithm>	// std::nth_element, std::min, std::max
+#include <cmath>		// sqrt, fabs
+
+#include "Parallel.h"
+
+// curvature of the surface at (u, v). degenerate points (e.g. poles) are evaluated slightly inside the parameter domain.
+static void curvatureAt(const NURBS_Surface& surface, float u, float v, float& K, float& H, float& k1, float& k2)
+{
+	// derivatives up to order 2: S[0] = S, S[1] = Sv, S[2] = Svv, S[3] = Su, S[4] = Suv, S[6] = Suu
+	Vec3f S[9];
+	surface.evaluateDerivatives(u, v, 2, S);
+	Vec3f normal = S[3] ^ S[1];
+	if (normal.sqlength() < 1e-12f)
+	{
+		const unsigned int p = surface.degree;
+		const float minU = surface.knotVectorU[p];
+		const float maxU = surface.knotVectorU[surface.controlPoints[0].size()];
+		const float minV = surface.knotVectorV[p];
+		const float maxV = surface.knotVectorV[surface.controlPoints.size()];
+		u += (u < 0.5f * (minU + maxU) ? 1e-3f : -1e-3f) * (maxU - minU);
+		v += (v < 0.5f * (minV + maxV) ? 1e-3f : -1e-3f) * (maxV - minV);
+		surface.evaluateDerivatives(u, v, 2, S);
+		normal = S[3] ^ S[1];
+	}
+	normal.normalize();
+	// first fundamental form
+	float E = S[3] * S[3];
+	float F = S[3] * S[1];
+	float G = S[1] * S[1];
+	// second fundamental form
+	float L = S[6] * normal;
+	float M = S[4] * normal;
+	float N = S[2] * normal;
+	float det = E * G - F * F;
+	if (std::fabs(det) < 1e-12f)
+	{
+		K = H = k1 = k2 = 0.0f;
+		return;
+	}
+	K = (L * N - M * M) / det;
+	H = (E * N - 2.0f * F * M + G * L) / (2.0f * det);
+	float root = sqrt(std::max(H * H - K, 0.0f));
+	k1 = H + root;
+	k2 = H - root;
+}
+
+void prepareCurvatureMaps(const std::vector<float>& parametersU, const std::vector<float>& parametersV, CurvatureMaps& maps)
+{
+	const size_t count = parametersU.size() * parametersV.size();
+	maps.gaussian.resize(count);
+	maps.mean.resize(count);
+	maps.maxPrincipal.resize(count);
+	maps.minPrincipal.resize(count);
+}
+
+void computeCurvatureRows(const NURBS_Surface& surface, const std::vector<float>& parametersU, const std::vector<float>& parametersV, const size_t rowBegin, const size_t rowEnd, CurvatureMaps& maps)
+{
+	const size_t numPointsV = parametersV.size();
+	for (size_t i = rowBegin; i < rowEnd; i++)
+	{
+		for (size_t j = 0; j < numPointsV; j++)
+		{
+			size_t n = i * numPointsV + j;
+			curvatureAt(surface, parametersU[i], parametersV[j], maps.gaussian[n], maps.mean[n], maps.maxPrincipal[n], maps.minPrincipal[n]);
+		}
+	}
+}
+
+void computeCurvatureMaps(const NURBS_Surface& surface, const std::vector<float>& parametersU, const std::vector<float>& parametersV, CurvatureMaps& maps)
+{
+	prepareCurvatureMaps(parametersU, parametersV, maps);
+	// tiles of whole rows, every tile writes its own part of the maps
+	parallelFor(parametersU.size(), 4, [&](size_t rowBegin, size_t rowEnd)
+	{
+		computeCurvatureRows(surface, parametersU, parametersV, rowBegin, rowEnd, maps);
+	});
+}
+
+void computeCurvatureColors(const CurvatureMaps& maps, const CurvatureType type, std::vector<Vec3f>& colors)
+{
+	const std::vector<float>* values = nullptr;
+	switch (type)
+	{
+	case CURVATURE_GAUSSIAN: values = &maps.gaussian; break;
+	case CURVATURE_MEAN: values = &maps.mean; break;
+	case CURVATURE_MAX_PRINCIPAL: values = &maps.maxPrincipal; break;
+	case CURVATURE_MIN_PRINCIPAL: values = &maps.minPrincipal; break;
+	default: break;
+	}
+	colors.clear();
+	if (values == nullptr || values->empty()) return;
+	// robust symmetric range: 95th percentile of the absolute values
+	std::vector<float> magnitudes(values->size());
+	for (size_t i = 0; i < values->size(); i++) magnitudes[i] = std::fabs((*values)[i]);
+	std::vector<float>::iterator percentile = magnitudes.begin() + (magnitudes.size() * 95) / 100;
+	std::nth_element(magnitudes.begin(), percentile, magnitudes.end());
+	float range = std::max(*percentile, 1e-6f);
+	// diverging color map blue - white - red
+	colors.reserve(values->size());
+	for (auto value : *values)
+	{
+		float x = std::min(std::max(value / range, -1.0f), 1.0f);
+		if (x >= 0.0f) colors.push_back(Vec3f(1.0f, 1.0f - x, 1.0f - x));
+		else colors.push_back(Vec3f(1.0f + x, 1.0f + x, 1.0f));
+	}
+}
+
+const char* curvatureName(const CurvatureType type)
+{
+	switch (type)
+	{
+	case CURVATURE_GAUSSIAN: return "gaussian";
+	case CURVATURE_MEAN: return "mean";
+	case CURVATURE_MAX_PRINCIPAL: return "max principal";
+	case CURVATURE_MIN_PRINCIPAL: return "min principal";
+	default: return "none";
+	}
+}
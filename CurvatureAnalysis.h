@@ -0,0 +1,47 @@
+#ifndef CURVATURE_ANALYSIS_H
+#define CURVATURE_ANALYSIS_H
+
+#include <stdlib.h>			// standard library
+#include <vector>			// std::vector<>
+
+#include "NURBS_Surface.h"
+#include "Vec3.h"
+
+// curvature values which can be shown on the surface
+enum CurvatureType
+{
+	CURVATURE_NONE = 0,
+	CURVATURE_GAUSSIAN,
+	CURVATURE_MEAN,
+	CURVATURE_MAX_PRINCIPAL,
+	CURVATURE_MIN_PRINCIPAL,
+	CURVATURE_TYPE_COUNT
+};
+
+// per-vertex curvature of a tessellated surface, same layout as the tessellated points (index u * numPointsV + v)
+struct CurvatureMaps
+{
+	std::vector<float> gaussian;		// K = k1 * k2
+	std::vector<float> mean;			// H = (k1 + k2) / 2
+	std::vector<float> maxPrincipal;	// k1
+	std::vector<float> minPrincipal;	// k2 <= k1
+};
+
+// compute the curvature maps from the first and second fundamental form at all grid points (parametersU x parametersV).
+// the grid is processed in parallel tiles of rows.
+void computeCurvatureMaps(const NURBS_Surface& surface, const std::vector<float>& parametersU, const std::vector<float>& parametersV, CurvatureMaps& maps);
+
+// resize the maps for the grid parametersU x parametersV
+void prepareCurvatureMaps(const std::vector<float>& parametersU, const std::vector<float>& parametersV, CurvatureMaps& maps);
+
+// compute the grid rows (fixed u) [rowBegin, rowEnd) of the prepared maps. rows may be computed concurrently.
+void computeCurvatureRows(const NURBS_Surface& surface, const std::vector<float>& parametersU, const std::vector<float>& parametersV, const size_t rowBegin, const size_t rowEnd, CurvatureMaps& maps);
+
+// map the selected curvature to per-vertex colors: blue for negative, white for zero and red for positive values.
+// the color range is symmetric and clipped at the 95th percentile of the absolute values. CURVATURE_NONE clears the colors.
+void computeCurvatureColors(const CurvatureMaps& maps, const CurvatureType type, std::vector<Vec3f>& colors);
+
+// returns a printable name of the curvature type
+const char* curvatureName(const CurvatureType type);
+
+#endif // CURVATURE_ANALYSIS_H
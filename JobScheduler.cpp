@@ -0,0 +1,212 @@
+#include "JobScheduler.h"
+
+#include <chrono>		// std::chrono::milliseconds
+
+// scheduler and queue index of the calling thread if it is a worker
+static thread_local JobScheduler* currentScheduler = nullptr;
+static thread_local size_t currentWorker = 0;
+
+// =====================
+// === JobScheduler ===
+// =====================
+
+JobScheduler::JobScheduler(const size_t numWorkers /*= 0*/) : queuedTasks(0), stopping(false)
+{
+	size_t count = numWorkers;
+	if (count == 0) count = std::max(2u, std::thread::hardware_concurrency()) - 1;
+	for (size_t i = 0; i < count; i++) queues.push_back(std::unique_ptr<WorkerQueue>(new WorkerQueue()));
+	workers.reserve(count);
+	for (size_t i = 0; i < count; i++) workers.push_back(std::thread(&JobScheduler::workerLoop, this, i));
+}
+
+JobScheduler::~JobScheduler()
+{
+	{
+		std::lock_guard<std::mutex> lock(sleepMutex);
+		stopping = true;
+	}
+	workAvailable.notify_all();
+	for (auto& worker : workers) worker.join();
+}
+
+JobScheduler& JobScheduler::global()
+{
+	static JobScheduler scheduler;
+	return scheduler;
+}
+
+void JobScheduler::run(std::vector<Job>& jobs)
+{
+	if (jobs.empty()) return;
+	std::stable_sort(jobs.begin(), jobs.end(), [](const Job& a, const Job& b) { return a.cost > b.cost; });
+	TaskGroup group(*this);
+	for (Job& job : jobs) group.run(job.work);
+	group.wait();
+}
+
+void JobScheduler::submit(Task task)
+{
+	WorkerQueue& queue = currentScheduler == this ? *queues[currentWorker] : sharedQueue;
+	{
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		queue.tasks.push_back(std::move(task));
+	}
+	queuedTasks++;
+	// lock to not miss a worker which checked queuedTasks but does not wait yet
+	{
+		std::lock_guard<std::mutex> lock(sleepMutex);
+	}
+	workAvailable.notify_one();
+}
+
+bool JobScheduler::takeFrom(std::deque<Task>& tasks, const TaskGroup* group, const bool back, Task& task)
+{
+	if (tasks.empty()) return false;
+	if (!group)
+	{
+		if (back)
+		{
+			task = std::move(tasks.back());
+			tasks.pop_back();
+		}
+		else
+		{
+			task = std::move(tasks.front());
+			tasks.pop_front();
+		}
+		return true;
+	}
+	if (back)
+	{
+		for (auto it = tasks.rbegin(); it != tasks.rend(); ++it)
+		{
+			if (it->group != group) continue;
+			task = std::move(*it);
+			tasks.erase(std::next(it).base());
+			return true;
+		}
+	}
+	else
+	{
+		for (auto it = tasks.begin(); it != tasks.end(); ++it)
+		{
+			if (it->group != group) continue;
+			task = std::move(*it);
+			tasks.erase(it);
+			return true;
+		}
+	}
+	return false;
+}
+
+bool JobScheduler::takeTask(Task& task, const TaskGroup* group /*= nullptr*/)
+{
+	if (queuedTasks == 0) return false;
+	const bool isWorker = currentScheduler == this;
+	// own deque first (newest task)
+	if (isWorker)
+	{
+		WorkerQueue& own = *queues[currentWorker];
+		std::lock_guard<std::mutex> lock(own.mutex);
+		if (takeFrom(own.tasks, group, true, task))
+		{
+			queuedTasks--;
+			return true;
+		}
+	}
+	{
+		std::lock_guard<std::mutex> lock(sharedQueue.mutex);
+		if (takeFrom(sharedQueue.tasks, group, false, task))
+		{
+			queuedTasks--;
+			return true;
+		}
+	}
+	// steal the oldest task of another worker, starting with the next one to spread the thieves
+	const size_t start = isWorker ? currentWorker + 1 : 0;
+	for (size_t i = 0; i < queues.size(); i++)
+	{
+		const size_t victim = (start + i) % queues.size();
+		if (isWorker && victim == currentWorker) continue;
+		WorkerQueue& queue = *queues[victim];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		if (takeFrom(queue.tasks, group, false, task))
+		{
+			queuedTasks--;
+			return true;
+		}
+	}
+	return false;
+}
+
+void JobScheduler::execute(Task& task)
+{
+	if (!task.group->token.isCancelled()) task.work();
+	task.group->taskDone();
+}
+
+void JobScheduler::workerLoop(const size_t index)
+{
+	currentScheduler = this;
+	currentWorker = index;
+	while (true)
+	{
+		Task task;
+		if (takeTask(task))
+		{
+			execute(task);
+			continue;
+		}
+		std::unique_lock<std::mutex> lock(sleepMutex);
+		workAvailable.wait(lock, [this]() { return stopping || queuedTasks > 0; });
+		if (stopping && queuedTasks == 0) return;
+	}
+}
+
+// =================
+// === TaskGroup ===
+// =================
+
+TaskGroup::TaskGroup(JobScheduler& scheduler_ /*= JobScheduler::global()*/, const CancellationToken& token_ /*= CancellationToken()*/) : scheduler(scheduler_), token(token_), pendingTasks(0)
+{
+}
+
+TaskGroup::~TaskGroup()
+{
+	wait();
+}
+
+void TaskGroup::run(const std::function<void()>& work)
+{
+	pendingTasks++;
+	JobScheduler::Task task;
+	task.work = work;
+	task.group = this;
+	scheduler.submit(std::move(task));
+}
+
+void TaskGroup::wait()
+{
+	// help with the tasks of this group only. running an unrelated (maybe long) task here could block the waiting
+	// thread far longer than the group needs.
+	while (pendingTasks > 0)
+	{
+		JobScheduler::Task task;
+		if (scheduler.takeTask(task, this))
+		{
+			scheduler.execute(task);
+			continue;
+		}
+		// the remaining tasks run on other threads
+		std::unique_lock<std::mutex> lock(mutex);
+		done.wait_for(lock, std::chrono::milliseconds(1), [this]() { return pendingTasks == 0; });
+	}
+	// taskDone() may still hold the mutex after the last decrement
+	std::lock_guard<std::mutex> lock(mutex);
+}
+
+void TaskGroup::taskDone()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	if (--pendingTasks == 0) done.notify_all();
+}
@@ -0,0 +1,192 @@
+#ifndef JOB_SCHEDULER_H
+#define JOB_SCHEDULER_H
+
+#include <stdlib.h>				// standard library
+#include <algorithm>			// std::min, std::max
+#include <atomic>				// std::atomic<>
+#include <condition_variable>	// std::condition_variable
+#include <deque>				// std::deque<>
+#include <functional>			// std::function<>
+#include <memory>				// std::shared_ptr<>, std::unique_ptr<>
+#include <mutex>				// std::mutex
+#include <thread>				// std::thread
+#include <vector>				// std::vector<>
+
+// a piece of work with an estimated cost (arbitrary unit, only the ratios matter)
+struct Job
+{
+	double cost;
+	std::function<void()> work;
+
+	Job() : cost(0.0)
+	{
+	}
+
+	Job(const double cost_, const std::function<void()>& work_) : cost(cost_), work(work_)
+	{
+	}
+};
+
+// shared flag to cancel a group of tasks cooperatively. copies refer to the same flag.
+class CancellationToken
+{
+
+public:
+
+	CancellationToken() : flag(std::make_shared<std::atomic<bool>>(false))
+	{
+	}
+
+	void cancel() { *flag = true; }
+	bool isCancelled() const { return *flag; }
+
+private:
+
+	std::shared_ptr<std::atomic<bool>> flag;
+
+};
+
+class TaskGroup;
+
+// work-stealing task scheduler with a fixed pool of worker threads.
+// every worker owns a deque: it pushes and pops its own tasks at the back (depth first, cache friendly) while idle
+// workers steal from the front of the others (the oldest and usually largest tasks). tasks submitted by other threads
+// go to a shared queue. a thread waiting for a task group runs the queued tasks of that group meanwhile, so waiting
+// inside a task (nested parallelism) does not block a worker.
+class JobScheduler
+{
+
+public:
+
+	// starts numWorkers threads (0: one less than the hardware threads, but at least one so background work always
+	// progresses even if the submitting thread never waits)
+	explicit JobScheduler(const size_t numWorkers = 0);
+
+	// stops the workers. all task groups have to be finished.
+	~JobScheduler();
+
+	// the scheduler shared by the application
+	static JobScheduler& global();
+
+	// number of threads working on a waited-for batch (workers and the waiting thread)
+	size_t concurrency() const { return workers.size() + 1; }
+
+	// run all jobs and return when they are done. the jobs are started in order of decreasing cost
+	// (longest processing time first), so the expensive ones do not end up last on a single core.
+	void run(std::vector<Job>& jobs);
+
+	// calls func(begin, end) for chunks of at least grainSize indices covering [0, count) and returns when all are done.
+	// remaining chunks are skipped once token is cancelled.
+	template<class Func>
+	void parallelFor(const size_t count, const size_t grainSize, Func func, const CancellationToken* token = nullptr);
+
+private:
+
+	friend class TaskGroup;
+
+	struct Task
+	{
+		std::function<void()> work;
+		TaskGroup* group;
+	};
+
+	// deque of one worker, stolen from at the front
+	struct WorkerQueue
+	{
+		std::mutex mutex;
+		std::deque<Task> tasks;
+	};
+
+	JobScheduler(const JobScheduler&);
+	JobScheduler& operator=(const JobScheduler&);
+
+	// queue a task of group: on the own deque of a worker, else on the shared queue
+	void submit(Task task);
+
+	// take a task: the back of the own deque, the shared queue or the front of another deque.
+	// only tasks of group are taken unless it is nullptr. returns false if there is none.
+	bool takeTask(Task& task, const TaskGroup* group = nullptr);
+
+	// take the first task of group (any task if group is nullptr) from the back or the front of tasks
+	static bool takeFrom(std::deque<Task>& tasks, const TaskGroup* group, const bool back, Task& task);
+
+	// run a task and report it to its group
+	void execute(Task& task);
+
+	// body of the worker threads
+	void workerLoop(const size_t index);
+
+	std::vector<std::thread> workers;
+	std::vector<std::unique_ptr<WorkerQueue>> queues;	// one per worker
+	WorkerQueue sharedQueue;							// tasks of non-worker threads
+	std::atomic<size_t> queuedTasks;					// tasks in all queues
+	std::mutex sleepMutex;
+	std::condition_variable workAvailable;
+	bool stopping;
+
+};
+
+// set of tasks which can be waited for. tasks of a cancelled group are skipped.
+class TaskGroup
+{
+
+public:
+
+	explicit TaskGroup(JobScheduler& scheduler_ = JobScheduler::global(), const CancellationToken& token_ = CancellationToken());
+
+	// waits for all tasks
+	~TaskGroup();
+
+	// queue a task
+	void run(const std::function<void()>& work);
+
+	// run queued tasks of this group until all of them are done
+	void wait();
+
+	// true if the group has unfinished tasks
+	bool isBusy() const { return pendingTasks > 0; }
+
+	void cancel() { token.cancel(); }
+	const CancellationToken& cancellationToken() const { return token; }
+
+private:
+
+	friend class JobScheduler;
+
+	TaskGroup(const TaskGroup&);
+	TaskGroup& operator=(const TaskGroup&);
+
+	// called by the scheduler after a task of the group ran
+	void taskDone();
+
+	JobScheduler& scheduler;
+	CancellationToken token;
+	std::atomic<size_t> pendingTasks;
+	std::mutex mutex;
+	std::condition_variable done;
+
+};
+
+template<class Func>
+void JobScheduler::parallelFor(const size_t count, const size_t grainSize, Func func, const CancellationToken* token /*= nullptr*/)
+{
+	if (count == 0) return;
+	// several chunks per thread to balance uneven work
+	const size_t chunkSize = std::max(std::max(grainSize, size_t(1)), count / (concurrency() * 4) + 1);
+	const size_t numChunks = (count + chunkSize - 1) / chunkSize;
+	if (numChunks == 1)
+	{
+		if (!token || !token->isCancelled()) func(size_t(0), count);
+		return;
+	}
+	TaskGroup group(*this, token ? *token : CancellationToken());
+	for (size_t chunk = 0; chunk < numChunks; chunk++)
+	{
+		const size_t begin = chunk * chunkSize;
+		const size_t end = std::min(begin + chunkSize, count);
+		group.run([&func, begin, end]() { func(begin, end); });
+	}
+	group.wait();
+}
+
+#endif // JOB_SCHEDULER_H
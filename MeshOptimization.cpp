@@ -0,0 +1,268 @@
+#include "MeshOptimization.h"
+
+#include <algorithm>		// std::min, std::max
+#include <cmath>			// floor
+#include <unordered_map>	// std::unordered_map<>
+
+#include "Profiler.h"
+
+static const unsigned int NO_VERTEX = ~0u;
+
+// key of a cell of the welding grid
+static unsigned long long cellKey(const long long x, const long long y, const long long z)
+{
+	// 21 bits per axis, neighbouring cells of far apart points may share a key which only costs a distance test
+	const unsigned long long mask = (1ull << 21) - 1;
+	return ((unsigned long long)x & mask) | (((unsigned long long)y & mask) << 21) | (((unsigned long long)z & mask) << 42);
+}
+
+// merge samples closer than tolerance. fills gridVertices and vertexSamples, the positions and the sums of the sample normals.
+static void weldSamples(const TessellatedMesh& mesh, const float relativeTolerance, IndexedMesh& indexed)
+{
+	const size_t numSamples = mesh.points.size();
+	const std::vector<Vec3f>& positions = mesh.points;
+	Vec3f lower(1e30f, 1e30f, 1e30f);
+	Vec3f upper(-1e30f, -1e30f, -1e30f);
+	for (size_t i = 0; i < numSamples; i++)
+	{
+		for (unsigned int k = 0; k < 3; k++)
+		{
+			lower[k] = std::min(lower[k], positions[i][k]);
+			upper[k] = std::max(upper[k], positions[i][k]);
+		}
+	}
+	const float tolerance = std::max(relativeTolerance * (upper - lower).length(), 1e-12f);
+	// cells of four times the tolerance: the tolerance box around a point mostly lies in a single cell
+	const float cellSize = 4.0f * tolerance;
+
+	std::unordered_map<unsigned long long, unsigned int> cells;	// first vertex of every cell
+	std::vector<unsigned int> nextInCell;						// further vertices of the same cell
+	cells.reserve(numSamples);
+	indexed.points.clear();
+	indexed.normals.clear();
+	indexed.vertexSamples.clear();
+	indexed.gridVertices.resize(numSamples);
+	for (size_t i = 0; i < numSamples; i++)
+	{
+		const Vec3f& p = positions[i];
+		long long from[3], to[3];
+		for (unsigned int k = 0; k < 3; k++)
+		{
+			from[k] = (long long)floor((p[k] - lower[k] - tolerance) / cellSize);
+			to[k] = (long long)floor((p[k] - lower[k] + tolerance) / cellSize);
+		}
+		unsigned int vertex = NO_VERTEX;
+		for (long long x = from[0]; x <= to[0] && vertex == NO_VERTEX; x++)
+			for (long long y = from[1]; y <= to[1] && vertex == NO_VERTEX; y++)
+				for (long long z = from[2]; z <= to[2] && vertex == NO_VERTEX; z++)
+				{
+					auto cell = cells.find(cellKey(x, y, z));
+					if (cell == cells.end()) continue;
+					for (unsigned int candidate = cell->second; candidate != NO_VERTEX; candidate = nextInCell[candidate])
+					{
+						if ((indexed.points[candidate] - p).sqlength() > tolerance * tolerance) continue;
+						vertex = candidate;
+						break;
+					}
+				}
+		if (vertex == NO_VERTEX)
+		{
+			vertex = (unsigned int)indexed.points.size();
+			indexed.points.push_back(p);
+			indexed.normals.push_back(Vec3f());
+			indexed.vertexSamples.push_back((unsigned int)i);
+			const long long x = (long long)floor((p[0] - lower[0]) / cellSize);
+			const long long y = (long long)floor((p[1] - lower[1]) / cellSize);
+			const long long z = (long long)floor((p[2] - lower[2]) / cellSize);
+			auto inserted = cells.insert(std::make_pair(cellKey(x, y, z), vertex));
+			nextInCell.push_back(inserted.second ? NO_VERTEX : inserted.first->second);
+			inserted.first->second = vertex;
+		}
+		// unit sample normals, so every merged sample contributes equally
+		indexed.normals[vertex] += mesh.normals[i];
+		indexed.gridVertices[i] = vertex;
+	}
+}
+
+void buildIndexedMesh(const TessellatedMesh& mesh, IndexedMesh& indexed, const float relativeTolerance /*= WELD_RELATIVE_TOLERANCE*/)
+{
+	PROFILE_SCOPE("buildIndexedMesh");
+	indexed = IndexedMesh();
+	if (mesh.points.empty() || mesh.normals.size() != mesh.points.size()) return;
+	weldSamples(mesh, relativeTolerance, indexed);
+
+	// two triangles per grid cell, triangles which collapsed to an edge or a point are dropped
+	const size_t numU = mesh.numPointsU;
+	const size_t numV = mesh.numPointsV;
+	if (numU > 1 && numV > 1) indexed.indices.reserve((numU - 1) * (numV - 1) * 6);
+	auto addTriangle = [&indexed](const unsigned int a, const unsigned int b, const unsigned int c)
+	{
+		if (a == b || b == c || a == c) return;
+		indexed.indices.push_back(a);
+		indexed.indices.push_back(b);
+		indexed.indices.push_back(c);
+	};
+	for (size_t i = 0; i + 1 < numU; i++)
+	{
+		for (size_t j = 0; j + 1 < numV; j++)
+		{
+			const unsigned int n1 = indexed.gridVertices[i * numV + j];
+			const unsigned int n2 = indexed.gridVertices[(i + 1) * numV + j];
+			const unsigned int n3 = indexed.gridVertices[i * numV + j + 1];
+			const unsigned int n4 = indexed.gridVertices[(i + 1) * numV + j + 1];
+			addTriangle(n1, n2, n3);
+			addTriangle(n3, n2, n4);
+		}
+	}
+
+	// the samples at poles have no normal of their own, take the area weighted normal of the adjacent triangles
+	std::vector<Vec3f> faceNormals(indexed.points.size());
+	for (size_t t = 0; t < indexed.indices.size(); t += 3)
+	{
+		const Vec3f& a = indexed.points[indexed.indices[t]];
+		Vec3f normal = (indexed.points[indexed.indices[t + 1]] - a) ^ (indexed.points[indexed.indices[t + 2]] - a);
+		// orient like the sample normals of the corners
+		Vec3f orientation = indexed.normals[indexed.indices[t]] + indexed.normals[indexed.indices[t + 1]] + indexed.normals[indexed.indices[t + 2]];
+		if (normal * orientation < 0.0f) normal = normal * -1.0f;
+		for (unsigned int k = 0; k < 3; k++) faceNormals[indexed.indices[t + k]] += normal;
+	}
+	for (size_t v = 0; v < indexed.points.size(); v++)
+		if (!indexed.normals[v].normalize()) indexed.normals[v] = faceNormals[v].normalized();
+
+	indexed.gridACMR = averageCacheMissRatio(indexed.indices, indexed.points.size());
+	optimizeVertexCache(indexed.indices, indexed.points.size());
+	indexed.optimizedACMR = averageCacheMissRatio(indexed.indices, indexed.points.size());
+
+	// number the vertices in order of their first use, so the vertex fetch also walks the arrays linearly
+	std::vector<unsigned int> newIndex(indexed.points.size(), NO_VERTEX);
+	unsigned int numUsed = 0;
+	for (unsigned int& index : indexed.indices)
+	{
+		if (newIndex[index] == NO_VERTEX) newIndex[index] = numUsed++;
+		index = newIndex[index];
+	}
+	// vertices of no triangle (e.g. of a single row) keep their order at the end
+	for (unsigned int& index : newIndex)
+		if (index == NO_VERTEX) index = numUsed++;
+	std::vector<Vec3f> points(indexed.points.size());
+	std::vector<Vec3f> normals(indexed.normals.size());
+	std::vector<unsigned int> vertexSamples(indexed.vertexSamples.size());
+	for (size_t v = 0; v < newIndex.size(); v++)
+	{
+		points[newIndex[v]] = indexed.points[v];
+		normals[newIndex[v]] = indexed.normals[v];
+		vertexSamples[newIndex[v]] = indexed.vertexSamples[v];
+	}
+	indexed.points.swap(points);
+	indexed.normals.swap(normals);
+	indexed.vertexSamples.swap(vertexSamples);
+	for (unsigned int& vertex : indexed.gridVertices) vertex = newIndex[vertex];
+}
+
+void optimizeVertexCache(std::vector<unsigned int>& indices, const size_t numVertices, const unsigned int cacheSize /*= VERTEX_CACHE_SIZE*/)
+{
+	PROFILE_SCOPE("optimizeVertexCache");
+	const size_t numTriangles = indices.size() / 3;
+	if (numTriangles == 0) return;
+
+	// triangles adjacent to every vertex
+	std::vector<unsigned int> liveTriangles(numVertices, 0);
+	for (unsigned int index : indices) liveTriangles[index]++;
+	std::vector<size_t> adjacencyOffsets(numVertices + 1, 0);
+	for (size_t v = 0; v < numVertices; v++) adjacencyOffsets[v + 1] = adjacencyOffsets[v] + liveTriangles[v];
+	std::vector<unsigned int> adjacency(indices.size());
+	{
+		std::vector<size_t> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+		for (size_t i = 0; i < indices.size(); i++) adjacency[fill[indices[i]]++] = (unsigned int)(i / 3);
+	}
+
+	// a vertex is in the cache if it was loaded less than cacheSize loads ago
+	std::vector<long long> loadTime(numVertices, -(long long)cacheSize - 1);
+	long long time = 0;
+	std::vector<bool> emitted(numTriangles, false);
+	std::vector<unsigned int> deadEnds;		// recently used vertices, to continue after a dead end
+	std::vector<unsigned int> candidates;
+	std::vector<unsigned int> output;
+	output.reserve(numTriangles * 3);
+	size_t scan = 0;						// all vertices before have no live triangles left
+	long long fanning = 0;
+
+	while (fanning >= 0)
+	{
+		// emit all remaining triangles around the fanning vertex
+		candidates.clear();
+		for (size_t a = adjacencyOffsets[fanning]; a < adjacencyOffsets[fanning + 1]; a++)
+		{
+			const unsigned int triangle = adjacency[a];
+			if (emitted[triangle]) continue;
+			emitted[triangle] = true;
+			for (unsigned int k = 0; k < 3; k++)
+			{
+				const unsigned int v = indices[triangle * 3 + k];
+				output.push_back(v);
+				deadEnds.push_back(v);
+				candidates.push_back(v);
+				liveTriangles[v]--;
+				if (time - loadTime[v] > (long long)cacheSize) loadTime[v] = time++;
+			}
+		}
+
+		// next fanning vertex: the oldest candidate which stays in the cache while its remaining triangles are emitted
+		fanning = -1;
+		long long bestPriority = -1;
+		for (unsigned int v : candidates)
+		{
+			if (liveTriangles[v] == 0) continue;
+			long long priority = 0;
+			if (time - loadTime[v] + 2 * (long long)liveTriangles[v] <= (long long)cacheSize) priority = time - loadTime[v];
+			if (priority > bestPriority)
+			{
+				bestPriority = priority;
+				fanning = v;
+			}
+		}
+		if (fanning >= 0) continue;
+		// dead end: the most recent vertex with live triangles, else the next one in input order
+		while (!deadEnds.empty() && fanning < 0)
+		{
+			const unsigned int v = deadEnds.back();
+			deadEnds.pop_back();
+			if (liveTriangles[v] > 0) fanning = v;
+		}
+		while (fanning < 0 && scan < numVertices)
+		{
+			if (liveTriangles[scan] > 0) fanning = (long long)scan;
+			else scan++;
+		}
+	}
+	indices.swap(output);
+}
+
+float averageCacheMissRatio(const std::vector<unsigned int>& indices, const size_t numVertices, const unsigned int cacheSize /*= VERTEX_CACHE_SIZE*/)
+{
+	if (indices.size() < 3) return 0.0f;
+	std::vector<long long> loadTime(numVertices, -(long long)cacheSize - 1);
+	long long loads = 0;
+	for (unsigned int index : indices)
+		if (loads - loadTime[index] > (long long)cacheSize) loadTime[index] = loads++;
+	return (float)loads / (float)(indices.size() / 3);
+}
+
+void gatherVertexAttribute(const IndexedMesh& indexed, const std::vector<Vec3f>& sampleValues, std::vector<Vec3f>& vertexValues)
+{
+	vertexValues.clear();
+	if (sampleValues.size() != indexed.gridVertices.size()) return;
+	vertexValues.resize(indexed.vertexSamples.size());
+	for (size_t v = 0; v < indexed.vertexSamples.size(); v++) vertexValues[v] = sampleValues[indexed.vertexSamples[v]];
+}
+
+size_t unindexedMeshBytes(const size_t numPointsU, const size_t numPointsV)
+{
+	if (numPointsU < 2 || numPointsV < 2) return 0;
+	return (numPointsU - 1) * (numPointsV - 1) * 6 * 2 * sizeof(Vec3f);
+}
+
+size_t indexedMeshBytes(const IndexedMesh& indexed)
+{
+	return (indexed.points.size() + indexed.normals.size()) * sizeof(Vec3f) + indexed.indices.size() * sizeof(unsigned int);
+}
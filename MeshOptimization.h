@@ -0,0 +1,49 @@
+#ifndef MESH_OPTIMIZATION_H
+#define MESH_OPTIMIZATION_H
+
+#include <stdlib.h>			// standard library
+#include <vector>			// std::vector<>
+
+#include "Tessellation.h"
+#include "Vec3.h"
+
+// size of the simulated post-transform vertex cache (FIFO) for the ordering and the ACMR
+const unsigned int VERTEX_CACHE_SIZE = 16;
+
+// welded duplicates are closer than this fraction of the bounding box diagonal
+const float WELD_RELATIVE_TOLERANCE = 1e-5f;
+
+// indexed triangle mesh of a tessellated grid. coincident samples (seams of closed surfaces, collapsed rows at poles)
+// share one vertex and the triangles are ordered for the post-transform vertex cache.
+struct IndexedMesh
+{
+	std::vector<Vec3f> points;					// euclidean vertex positions
+	std::vector<Vec3f> normals;					// unit vertex normals
+	std::vector<unsigned int> indices;			// triangle list, degenerate triangles are removed
+	std::vector<unsigned int> gridVertices;		// vertex of every grid sample (index u * numPointsV + v), for the wireframe
+	std::vector<unsigned int> vertexSamples;	// one grid sample of every vertex, to map per-sample attributes
+	float gridACMR;								// average cache miss ratio (transformed vertices per triangle) in grid order
+	float optimizedACMR;						// ... after the reordering
+
+	IndexedMesh() : gridACMR(0.0f), optimizedACMR(0.0f)
+	{
+	}
+};
+
+// weld the samples of mesh, triangulate the grid and order the triangles for the vertex cache (Tipsify)
+void buildIndexedMesh(const TessellatedMesh& mesh, IndexedMesh& indexed, const float relativeTolerance = WELD_RELATIVE_TOLERANCE);
+
+// reorder the triangles of indices for a vertex cache of cacheSize entries (Tipsify, Sander et al. 2007)
+void optimizeVertexCache(std::vector<unsigned int>& indices, const size_t numVertices, const unsigned int cacheSize = VERTEX_CACHE_SIZE);
+
+// transformed vertices per triangle of a FIFO vertex cache with cacheSize entries (0.5 is optimal for large grids, 3 the worst)
+float averageCacheMissRatio(const std::vector<unsigned int>& indices, const size_t numVertices, const unsigned int cacheSize = VERTEX_CACHE_SIZE);
+
+// per-vertex copy of a per-sample attribute (e.g. curvature colors)
+void gatherVertexAttribute(const IndexedMesh& indexed, const std::vector<Vec3f>& sampleValues, std::vector<Vec3f>& vertexValues);
+
+// bytes of the vertex data drawn without indices (6 vertices per grid cell) and with the indexed mesh (position and normal)
+size_t unindexedMeshBytes(const size_t numPointsU, const size_t numPointsV);
+size_t indexedMeshBytes(const IndexedMesh& indexed);
+
+#endif // MESH_OPTIMIZATION_H
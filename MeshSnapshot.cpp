@@ -0,0 +1,37 @@
+#include "MeshSnapshot.h"
+
+#include "MeshOptimization.h"
+
+std::shared_ptr<MeshSnapshot> makeMeshSnapshot(const std::shared_ptr<const TessellationResult>& tessellation, const CurvatureType curvatureDisplay)
+{
+	std::shared_ptr<MeshSnapshot> snapshot = std::make_shared<MeshSnapshot>();
+	snapshot->tessellation = tessellation;
+	snapshot->curvatureDisplay = curvatureDisplay;
+	if (tessellation)
+	{
+		computeCurvatureColors(tessellation->curvatureMaps, curvatureDisplay, snapshot->curvatureColors);
+		gatherVertexAttribute(tessellation->indexedMesh, snapshot->curvatureColors, snapshot->vertexColors);
+	}
+	return snapshot;
+}
+
+MeshPublisher::MeshPublisher() : back(0), front(1), shared(2), publishedEpoch(0)
+{
+}
+
+std::shared_ptr<const MeshSnapshot> MeshPublisher::current() const
+{
+	// trade the front slot for the published one, the acquire makes the snapshot written by publish() visible
+	if (shared.load(std::memory_order_relaxed) & FRESH) front = shared.exchange(front, std::memory_order_acq_rel) & ~FRESH;
+	return slots[front];
+}
+
+void MeshPublisher::publish(const std::shared_ptr<MeshSnapshot>& next)
+{
+	// the epoch is counted before the swap, so a reader never sees a snapshot newer than epoch()
+	next->epoch = ++publishedEpoch;
+	slots[back] = next;
+	back = shared.exchange(back | FRESH, std::memory_order_acq_rel) & ~FRESH;
+	// the slot coming back holds a snapshot the reader has moved past (or never saw), release it here
+	slots[back].reset();
+}
@@ -0,0 +1,68 @@
+#ifndef MESH_SNAPSHOT_H
+#define MESH_SNAPSHOT_H
+
+#include <stdlib.h>			// standard library
+#include <atomic>			// std::atomic<>
+#include <memory>			// std::shared_ptr<>
+#include <vector>			// std::vector<>
+
+#include "AsyncTessellation.h"
+#include "CurvatureAnalysis.h"
+#include "Vec3.h"
+
+// everything the renderer draws of one tessellation. a snapshot is never modified after it was published, a new
+// tessellation or another curvature display builds and publishes a new snapshot instead.
+struct MeshSnapshot
+{
+	std::shared_ptr<const TessellationResult> tessellation;	// shared with the tessellation cache (nullptr: nothing tessellated)
+	CurvatureType curvatureDisplay;
+	std::vector<Vec3f> curvatureColors;		// per sample of tessellation->mesh (empty: white surface)
+	std::vector<Vec3f> vertexColors;		// curvatureColors of the vertices of tessellation->indexedMesh
+	unsigned long long epoch;				// set by MeshPublisher::publish, increases with every publication
+
+	MeshSnapshot() : curvatureDisplay(CURVATURE_NONE), epoch(0)
+	{
+	}
+};
+
+// builds a snapshot of tessellation (may be nullptr) colored by curvatureDisplay
+std::shared_ptr<MeshSnapshot> makeMeshSnapshot(const std::shared_ptr<const TessellationResult>& tessellation, const CurvatureType curvatureDisplay);
+
+// holds the newest snapshot. the producer builds the next snapshot on its own and swaps it in with publish(), the reader
+// takes the current one once per frame. neither side waits for the other: the snapshots are handed over in a triple buffer
+// whose slots are swapped through one atomic index, and the reader keeps its snapshot alive until it drops it, even if a
+// newer one was published meanwhile. publish() must be called from one thread at a time and current() from one (other)
+// thread at a time, which is what the GLUT main loop does.
+class MeshPublisher
+{
+
+public:
+
+	MeshPublisher();
+
+	// the newest published snapshot (nullptr before the first publication)
+	std::shared_ptr<const MeshSnapshot> current() const;
+
+	// stamps snapshot (not shared with other threads yet) with the next epoch and makes it the current one
+	void publish(const std::shared_ptr<MeshSnapshot>& snapshot);
+
+	// epoch of the newest snapshot (0 before the first publication)
+	unsigned long long epoch() const { return publishedEpoch; }
+
+private:
+
+	MeshPublisher(const MeshPublisher&);
+	MeshPublisher& operator=(const MeshPublisher&);
+
+	// flag of the shared index: the slot behind it was published and not picked up by current() yet
+	static const unsigned int FRESH = 4;
+
+	std::shared_ptr<const MeshSnapshot> slots[3];	// each slot is owned by the producer (back), the reader (front) or neither (shared)
+	unsigned int back;								// slot publish() fills next, only used by the producer
+	mutable unsigned int front;						// slot current() returns, only used by the reader
+	mutable std::atomic<unsigned int> shared;		// slot in between plus the FRESH flag, swapped by both sides
+	std::atomic<unsigned long long> publishedEpoch;
+
+};
+
+#endif // MESH_SNAPSHOT_H
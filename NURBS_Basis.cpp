@@ -0,0 +1,222 @@
+#include "NURBS_Basis.h"
+
+#include <algorithm>	// std::min, std::upper_bound
+#include <cmath>		// fabs
+
+int findSpan(const std::vector<float>& knotVector, const unsigned int degree, const size_t numControlPoints, const float u)
+{
+	const int n = (int)numControlPoints - 1;
+	// end of the parameter range: use the last non-empty span
+	if (u >= knotVector[n + 1])
+	{
+		int k = n;
+		while (k > (int)degree && knotVector[k] == knotVector[n + 1]) k--;
+		return k;
+	}
+	if (u <= knotVector[degree])
+	{
+		int k = (int)degree;
+		while (k < n && knotVector[k + 1] == knotVector[degree]) k++;
+		return k;
+	}
+	// binary search for the first knot bigger than u
+	std::vector<float>::const_iterator it = std::upper_bound(knotVector.begin() + degree, knotVector.begin() + n + 1, u);
+	return (int)(it - knotVector.begin()) - 1;
+}
+
+void basisFunctionDerivatives(const std::vector<float>& knotVector, const unsigned int degree, const int span, const float u, const unsigned int n, float* ders)
+{
+	const int p = (int)degree;
+	const int stride = p + 1;
+	float ndu[NURBS_MAX_DEGREE + 1][NURBS_MAX_DEGREE + 1];
+	float a[2][NURBS_MAX_DEGREE + 1];
+	float left[NURBS_MAX_DEGREE + 1];
+	float right[NURBS_MAX_DEGREE + 1];
+
+	// basis functions and knot differences
+	ndu[0][0] = 1.0f;
+	for (int j = 1; j <= p; j++)
+	{
+		left[j] = u - knotVector[span + 1 - j];
+		right[j] = knotVector[span + j] - u;
+		float saved = 0.0f;
+		for (int r = 0; r < j; r++)
+		{
+			// lower triangle
+			ndu[j][r] = right[r + 1] + left[j - r];
+			float temp = ndu[r][j - 1] / ndu[j][r];
+			// upper triangle
+			ndu[r][j] = saved + right[r + 1] * temp;
+			saved = left[j - r] * temp;
+		}
+		ndu[j][j] = saved;
+	}
+	for (int j = 0; j <= p; j++) ders[j] = ndu[j][p];
+
+	// derivatives
+	const int maxOrder = std::min((int)n, p);
+	for (int r = 0; r <= p; r++)
+	{
+		int s1 = 0;
+		int s2 = 1;
+		a[0][0] = 1.0f;
+		for (int k = 1; k <= maxOrder; k++)
+		{
+			float d = 0.0f;
+			int rk = r - k;
+			int pk = p - k;
+			if (r >= k)
+			{
+				a[s2][0] = a[s1][0] / ndu[pk + 1][rk];
+				d = a[s2][0] * ndu[rk][pk];
+			}
+			int j1 = (rk >= -1) ? 1 : -rk;
+			int j2 = (r - 1 <= pk) ? k - 1 : p - r;
+			for (int j = j1; j <= j2; j++)
+			{
+				a[s2][j] = (a[s1][j] - a[s1][j - 1]) / ndu[pk + 1][rk + j];
+				d += a[s2][j] * ndu[rk + j][pk];
+			}
+			if (r <= pk)
+			{
+				a[s2][k] = -a[s1][k - 1] / ndu[pk + 1][r];
+				d += a[s2][k] * ndu[r][pk];
+			}
+			ders[k * stride + r] = d;
+			std::swap(s1, s2);
+		}
+	}
+	// multiply by the correct factors p!/(p-k)!
+	float factor = (float)p;
+	for (int k = 1; k <= maxOrder; k++)
+	{
+		for (int j = 0; j <= p; j++) ders[k * stride + j] *= factor;
+		factor *= (float)(p - k);
+	}
+	// derivatives of order > p vanish
+	for (int k = maxOrder + 1; k <= (int)n; k++)
+		for (int j = 0; j <= p; j++) ders[k * stride + j] = 0.0f;
+}
+
+float binomial(const unsigned int n, const unsigned int k)
+{
+	// pascal's triangle, built once
+	struct BinomialTable
+	{
+		float values[NURBS_MAX_DEGREE + 1][NURBS_MAX_DEGREE + 1];
+		BinomialTable()
+		{
+			for (unsigned int i = 0; i <= NURBS_MAX_DEGREE; i++)
+			{
+				values[i][0] = 1.0f;
+				values[i][i] = 1.0f;
+				for (unsigned int j = 1; j < i; j++) values[i][j] = values[i - 1][j - 1] + values[i - 1][j];
+				for (unsigned int j = i + 1; j <= NURBS_MAX_DEGREE; j++) values[i][j] = 0.0f;
+			}
+		}
+	};
+	static const BinomialTable table;
+	return table.values[n][k];
+}
+
+UniformKnotSpans findUniformKnotSpans(const std::vector<float>& knotVector, const unsigned int degree, const size_t numControlPoints)
+{
+	UniformKnotSpans uniform;
+	const size_t p = degree;
+	const size_t n = numControlPoints;
+	if (p == 0 || p > NURBS_MAX_DEGREE || n <= p || knotVector.size() != n + p + 1) return uniform;
+	// the mean knot distance within the parameter range [u_p, u_n]
+	const float spacing = (knotVector[n] - knotVector[p]) / float(n - p);
+	if (!(spacing > 0.0f)) return uniform;
+	const float tolerance = 1e-5f * spacing;
+	// each knot difference outside the parameter range is 0 (clamped) or h (uniform), all inside are h
+	bool clampedBegin = false;
+	bool clampedEnd = false;
+	for (size_t i = 0; i + 1 < knotVector.size(); i++)
+	{
+		const float difference = knotVector[i + 1] - knotVector[i];
+		const bool equidistant = std::fabs(difference - spacing) <= tolerance;
+		if (i < p)
+		{
+			if (difference == 0.0f) clampedBegin = true;
+			else if (!equidistant || clampedBegin) return uniform;
+		}
+		else if (i >= n)
+		{
+			if (difference == 0.0f) clampedEnd = true;
+			else if (!equidistant) return uniform;
+		}
+		else if (!equidistant) return uniform;
+	}
+	// a clamped end has to be clamped completely
+	if (clampedBegin && knotVector[0] != knotVector[p]) return uniform;
+	if (clampedEnd && knotVector[n] != knotVector[n + p]) return uniform;
+	// span k uses the knots u_k-p+1 .. u_k+p, the spans next to a clamped end see a multiple knot
+	uniform.begin = (int)(clampedBegin ? 2 * p - 1 : p);
+	uniform.end = (int)(clampedEnd ? n - p + 1 : n);
+	if (uniform.end < uniform.begin) uniform.end = uniform.begin;
+	uniform.spacing = spacing;
+	uniform.inverseSpacing = 1.0f / spacing;
+	return uniform;
+}
+
+const float* uniformBasisMatrix(const unsigned int degree)
+{
+	// Taylor coefficients of the basis functions on the knots 0, 1, ..., 2p + 1 at the start of span p, built once
+	struct UniformBasisTable
+	{
+		float matrices[NURBS_MAX_DEGREE + 1][(NURBS_MAX_DEGREE + 1) * (NURBS_MAX_DEGREE + 1)];
+		UniformBasisTable()
+		{
+			for (unsigned int p = 0; p <= NURBS_MAX_DEGREE; p++)
+			{
+				std::vector<float> knots(2 * p + 2);
+				for (unsigned int i = 0; i < knots.size(); i++) knots[i] = float(i);
+				float* M = matrices[p];
+				basisFunctionDerivatives(knots, p, (int)p, float(p), p, M);
+				float factorial = 1.0f;
+				for (unsigned int j = 2; j <= p; j++)
+				{
+					factorial *= float(j);
+					for (unsigned int i = 0; i <= p; i++) M[j * (p + 1) + i] /= factorial;
+				}
+			}
+		}
+	};
+	static const UniformBasisTable table;
+	return table.matrices[degree];
+}
+
+void basisFunctionDerivatives(const std::vector<float>& knotVector, const UniformKnotSpans& uniform, const unsigned int degree, const int span, const float u, const unsigned int n, float* ders)
+{
+	if (!uniform.contains(span))
+	{
+		basisFunctionDerivatives(knotVector, degree, span, u, n, ders);
+		return;
+	}
+	const unsigned int p = degree;
+	const float* M = uniformBasisMatrix(p);
+	// powers of the local parameter
+	float powers[NURBS_MAX_DEGREE + 1];
+	powers[0] = 1.0f;
+	const float s = (u - knotVector[span]) * uniform.inverseSpacing;
+	for (unsigned int j = 1; j <= p; j++) powers[j] = powers[j - 1] * s;
+	// the k-th derivative is sum_j j! / (j - k)! M[j][i] s^(j - k) times the chain rule factor h^-k. row j of M is scaled
+	// and added to all basis functions at once.
+	float scale = 1.0f;
+	for (unsigned int k = 0; k <= n; k++)
+	{
+		// local sums, the compiler cannot keep ders in registers (it might alias M)
+		float row[NURBS_MAX_DEGREE + 1] = {};
+		for (unsigned int j = k; j <= p; j++)
+		{
+			// j! / (j - k)!
+			float factor = scale * powers[j - k];
+			for (unsigned int m = 0; m < k; m++) factor *= float(j - m);
+			const float* Mj = M + j * (p + 1);
+			for (unsigned int i = 0; i <= p; i++) row[i] += factor * Mj[i];
+		}
+		for (unsigned int i = 0; i <= p; i++) ders[k * (p + 1) + i] = row[i];
+		scale *= uniform.inverseSpacing;
+	}
+}
@@ -0,0 +1,51 @@
+#ifndef NURBS_BASIS_H
+#define NURBS_BASIS_H
+
+#include <stdlib.h>			// standard library
+#include <vector>			// std::vector<>
+
+// highest degree supported by the basis function routines (they work on fixed size stack arrays)
+const unsigned int NURBS_MAX_DEGREE = 15;
+
+// find the knot span index k with u in [u_k, u_k+1) for a B-spline with numControlPoints control points.
+// u is clamped to the valid parameter range [u_p, u_n+1], the end of the range belongs to the last non-empty span.
+int findSpan(const std::vector<float>& knotVector, const unsigned int degree, const size_t numControlPoints, const float u);
+
+// compute the p+1 nonzero basis functions N_{k-p,p}(u) ... N_{k,p}(u) and their derivatives up to order n in span k.
+// ders has to hold (n+1)*(p+1) values, ders[j*(p+1)+i] is the j-th derivative of N_{k-p+i,p}(u). derivatives of order > p are 0.
+// (algorithm A2.3 from Piegl/Tiller "The NURBS Book")
+void basisFunctionDerivatives(const std::vector<float>& knotVector, const unsigned int degree, const int span, const float u, const unsigned int n, float* ders);
+
+// binomial coefficient (n over k) for n <= NURBS_MAX_DEGREE
+float binomial(const unsigned int n, const unsigned int k);
+
+// the knot spans [begin, end) whose 2p surrounding knots are equidistant. there the basis functions are translates of the
+// uniform B-spline basis and follow from one constant matrix (see uniformBasisMatrix) without any division by knot differences.
+struct UniformKnotSpans
+{
+	int begin;
+	int end;
+	float spacing;			// distance of the knots
+	float inverseSpacing;
+
+	UniformKnotSpans() : begin(0), end(0), spacing(0.0f), inverseSpacing(0.0f)
+	{
+	}
+
+	bool contains(const int span) const { return span >= begin && span < end; }
+
+	bool operator== (const UniformKnotSpans& other) const { return begin == other.begin && end == other.end && spacing == other.spacing; }
+};
+
+// detects uniform knot vectors (u_i = u_0 + i * h) and clamped uniform ones (the first and last p + 1 knots equal, equidistant
+// in between) and returns the spans which may use the uniform basis. other knot vectors give an empty range.
+UniformKnotSpans findUniformKnotSpans(const std::vector<float>& knotVector, const unsigned int degree, const size_t numControlPoints);
+
+// the uniform B-spline basis matrix of degree p (<= NURBS_MAX_DEGREE). M[j * (p + 1) + i] is the coefficient of s^j of basis
+// function N_{k-p+i} on span k with the local parameter s = (u - u_k) / h in [0, 1).
+const float* uniformBasisMatrix(const unsigned int degree);
+
+// same as basisFunctionDerivatives, but spans in uniform are evaluated with the uniform basis matrix
+void basisFunctionDerivatives(const std::vector<float>& knotVector, const UniformKnotSpans& uniform, const unsigned int degree, const int span, const float u, const unsigned int n, float* ders);
+
+#endif // NURBS_BASIS_H
@@ -2,11 +2,27 @@
 
 #include <stdio.h>		// cout
 #include <iostream>		// cout
+#include <algorithm>	// std::upper_bound
+#include <cmath>		// sqrt, fabs, exp2, log2
+#include <cassert>		// assert
+
+#include "NURBS_Basis.h"
+#include "NURBS_PowerBasis.h"
+#include "Parallel.h"
+#include "Profiler.h"
+
+// true if some weight differs from 1
+static bool hasWeights(const std::vector<Vec4f>& controlPoints)
+{
+	for (const Vec4f& point : controlPoints) if (point.w != 1.0f) return true;
+	return false;
+}
 
 NURBSCurve::NURBSCurve()
+	: degree(0)
+	, rational(false)
+	, validationResult(validateCurve(controlPoints, knotVector, degree))
 {
-	
-	isValidNURBS();
 }
 
 // constructor which takes given control points P, knot vector U and degree p
@@ -14,33 +30,102 @@ NURBSCurve::NURBSCurve(const std::vector<Vec4f>& controlPoints_, const std::vect
 	: controlPoints(controlPoints_)
 	, knotVector(knotVector_)
 	, degree(degree_)
+	, rational(hasWeights(controlPoints_))
+	, uniformSpans(findUniformKnotSpans(knotVector_, degree_, controlPoints_.size()))
+	, validationResult(validateCurve(controlPoints_, knotVector_, degree_))
 {
-	isValidNURBS();
 }
 
-bool NURBSCurve::isValidNURBS()
+NURBSCurve::NURBSCurve(const NURBSCurve& other)
+	: controlPoints(other.controlPoints)
+	, knotVector(other.knotVector)
+	, degree(other.degree)
+	, rational(other.rational)
+	, uniformSpans(other.uniformSpans)
+	, arcLengthTable(std::atomic_load(&other.arcLengthTable))
+	, polyline(std::atomic_load(&other.polyline))
+	, powerBasis(std::atomic_load(&other.powerBasis))
+	, validationResult(other.validationResult)
 {
-	// knot vector verification
-	bool validU = true;
-	for (unsigned int i = 1; i < knotVector.size() && validU == true; i++) if (knotVector[i] < knotVector[i-1])
+}
+
+NURBSCurve& NURBSCurve::operator=(const NURBSCurve& other)
+{
+	controlPoints = other.controlPoints;
+	knotVector = other.knotVector;
+	degree = other.degree;
+	rational = other.rational;
+	uniformSpans = other.uniformSpans;
+	std::atomic_store(&arcLengthTable, std::atomic_load(&other.arcLengthTable));
+	std::atomic_store(&polyline, std::atomic_load(&other.polyline));
+	std::atomic_store(&powerBasis, std::atomic_load(&other.powerBasis));
+	validationResult = other.validationResult;
+	return *this;
+}
+
+bool NURBSCurve::isValidNURBS() const
+{
+#ifdef NURBS_DEBUG_VALIDATION
+	// stale data means the curve was changed without invalidateCaches()
+	assert(validationResult == validateCurve(controlPoints, knotVector, degree));
+	assert(rational == hasWeights(controlPoints));
+	assert(uniformSpans == findUniformKnotSpans(knotVector, degree, controlPoints.size()));
+#endif
+	return validationResult.isValid();
+}
+
+
+void NURBSCurve::evaluateDerivatives(const float t, const unsigned int order, Vec3f* derivatives) const
+{
+	// the basis function and weight tables hold NURBS_MAX_DEGREE + 1 orders
+	if (!isValidNURBS() || order > NURBS_MAX_DEGREE)
+	{
+		for (unsigned int k = 0; k <= order; k++) derivatives[k] = Vec3f();
+		return;
+	}
+	const unsigned int p = degree;
+	float N[(NURBS_MAX_DEGREE + 1) * (NURBS_MAX_DEGREE + 1)];
+	int span = findSpan(knotVector, p, controlPoints.size(), t);
+	basisFunctionDerivatives(knotVector, uniformSpans, p, span, t, order, N);
+	// derivatives of the homogeneous curve: xyz go to derivatives[k], w to weights[k]
+	float weights[NURBS_MAX_DEGREE + 1];
+	for (unsigned int k = 0; k <= order; k++)
 	{
-		std::cout << "INVALID (unsorted) knotVector.\n";
-		validU = false;
-		break;
+		Vec4f A;
+		for (unsigned int i = 0; i <= p; i++) A += controlPoints[span - p + i] * N[k * (p + 1) + i];
+		derivatives[k] = Vec3f(A.x, A.y, A.z);
+		weights[k] = A.w;
 	}
-	// size verification
-	bool validSize = true;
-	if (controlPoints.size() + degree + 1 != knotVector.size()) 
+	// a polynomial curve is its homogeneous curve
+	if (!rational) return;
+	// derivatives of the rational curve, in place: C^(k) = (A^(k) - sum_i (k over i) w^(i) C^(k-i)) / w
+	for (unsigned int k = 0; k <= order; k++)
 	{
-		std::cout << "INVALID sizes (controlPoints.size() + degree + 1 != knotVector.size()).\n";
-		validSize = false;
+		Vec3f d = derivatives[k];
+		for (unsigned int i = 1; i <= k; i++) d -= derivatives[k - i] * (binomial(k, i) * weights[i]);
+		derivatives[k] = d / weights[0];
 	}
-	return (validU && validSize);
 }
 
+void NURBSCurve::evaluateDerivatives(const float t, const unsigned int order, std::vector<Vec3f>& derivatives) const
+{
+	derivatives.resize(order + 1);
+	evaluateDerivatives(t, order, derivatives.data());
+}
+
+std::vector<Vec3f> NURBSCurve::evaluateDerivativesAt(const std::vector<float>& T, const unsigned int order) const
+{
+	std::vector<Vec3f> derivatives(T.size() * (order + 1));
+	parallelFor(T.size(), 1024, [&](size_t begin, size_t end)
+	{
+		for (size_t i = begin; i < end; i++) evaluateDerivatives(T[i], order, &derivatives[i * (order + 1)]);
+	});
+	return derivatives;
+}
 
 bool NURBSCurve::insertKnot(const float newKnot)
 {
+	PROFILE_SCOPE("NURBSCurve::insertKnot");
 	// implement knot insertion with de Boor algorithm
 	// =====================================================
 	// get index k for inserting newKnot
@@ -55,7 +140,9 @@ bool NURBSCurve::insertKnot(const float newKnot)
 	for (int i = k - degree + 1; i <= k; i++)
 	{
 		float alpha = (newKnot - knotVector[i]) / (knotVector[i+degree] - knotVector[i]);
-		Q.push_back(alpha*controlPoints[i] + (1.0f - alpha) * controlPoints[i-1]);
+		Q.push_back(lerp(controlPoints[i-1], controlPoints[i], alpha));
+		// keep the weights of a polynomial curve exactly 1
+		if (!rational) Q.back().w = 1.0f;
 	}
 	// copy remaining control points
 	for (unsigned int i = k + 1; i <= controlPoints.size(); i ++) Q.push_back(controlPoints[i-1]);
@@ -66,52 +153,138 @@ bool NURBSCurve::insertKnot(const float newKnot)
 	it += k + 1;
 	knotVector.insert(it, newKnot);
 	// =====================================================
+	invalidateCaches();
 	return true;
 }
 
-Vec4f NURBSCurve::evaluteDeBoor(const float t, Vec4f& tangent)
+// tangent direction from control point t1 to t2, without the simple subtraction of homogeneous vectors
+static Vec4f homogeneousDifference(const Vec4f& t1, const Vec4f& t2)
+{
+	return Vec4f(t1.w * t2.x - t2.w * t1.x, t1.w * t2.y - t2.w * t1.y, t1.w * t2.z - t2.w * t1.z, t1.w * t2.w);
+}
+
+// the points of the de Boor triangle: homogeneous for rational curves, x, y, z only for polynomial ones (w is 1)
+static Vec4f triangleToHomogeneous(const Vec4f& point) { return point; }
+static Vec4f triangleToHomogeneous(const Vec3f& point) { return Vec4f(point.x, point.y, point.z, 1.0f); }
+static void triangleLoad(const Vec4f& point, Vec4f& d) { d = point; }
+static void triangleLoad(const Vec4f& point, Vec3f& d) { d = Vec3f(point.x, point.y, point.z); }
+
+// insert t r times into a local copy of the control points P_k-p .. P_k-p+r. returns the curve point
+// and the tangent from the neighbours of the curve point in the refined control polygon.
+template<class Point>
+static Vec4f deBoorTriangle(const std::vector<Vec4f>& controlPoints, const std::vector<float>& knotVector, const float t, const int k, const int p, const int r, Vec4f& tangent)
+{
+	Point d[NURBS_MAX_DEGREE + 1];
+	for (int j = 0; j <= r; j++) triangleLoad(controlPoints[k - p + j], d[j]);
+	for (int level = 1; level <= r; level++)
+	{
+		// the two points of the last but one insertion are the neighbours of the curve point
+		if (level == r) tangent = homogeneousDifference(triangleToHomogeneous(d[r - 1]), triangleToHomogeneous(d[r]));
+		// backwards, so d[j - 1] still holds the previous insertion
+		for (int j = r; j >= level; j--)
+		{
+			const int i = k - p + j;
+			float alpha = (t - knotVector[i]) / (knotVector[i + p - level + 1] - knotVector[i]);
+			d[j] = lerp(d[j - 1], d[j], alpha);
+		}
+	}
+	return triangleToHomogeneous(d[r]);
+}
+
+// the point at t in the uniform span k: blend P_k-p .. P_k with the basis functions from the uniform basis matrix. the
+// tangent is built from the two points the last de Boor step would blend, d_r = C + (1 - s) * D and d_r-1 = C - s * D with
+// D = C' * h / p, so it equals the tangent of deBoorTriangle.
+template<class Point>
+static Vec4f uniformSpanPoint(const std::vector<Vec4f>& controlPoints, const std::vector<float>& knotVector, const UniformKnotSpans& uniform, const float t, const int k, const int p, Vec4f& tangent)
+{
+	// basis functions N_i and their derivatives by s, dN_i: Horner's scheme on column i of the matrix
+	const float* M = uniformBasisMatrix(p);
+	const float s = (t - knotVector[k]) * uniform.inverseSpacing;
+	float N[NURBS_MAX_DEGREE + 1];
+	float dN[NURBS_MAX_DEGREE + 1];
+	for (int i = 0; i <= p; i++)
+	{
+		float value = M[p * (p + 1) + i];
+		float derivative = 0.0f;
+		for (int j = p - 1; j >= 0; j--)
+		{
+			derivative = derivative * s + value;
+			value = value * s + M[j * (p + 1) + i];
+		}
+		N[i] = value;
+		dN[i] = derivative;
+	}
+	// D = C' * h / p = dC/ds / p
+	const float derivativeScale = 1.0f / float(p);
+	Point C, D, d;
+	for (int i = 0; i <= p; i++)
+	{
+		triangleLoad(controlPoints[k - p + i], d);
+		C += d * N[i];
+		D += d * (dN[i] * derivativeScale);
+	}
+	tangent = homogeneousDifference(triangleToHomogeneous(C - D * s), triangleToHomogeneous(C + D * (1.0f - s)));
+	return triangleToHomogeneous(C);
+}
+
+Vec4f NURBSCurve::evaluteDeBoor(const float t, Vec4f& tangent) const
 {
-	// create a copy of this NURBS curve
-	NURBSCurve tempNURBS(*this);
-	// use insertKnot to evaluate the curve and its tangent. Take care to NOT modify this NURBS curve. Instead use the temporary copy.
+	// insert t until its multiplicity is p. only the control points P_k-p .. P_k-s change, so the insertion runs on a local
+	// copy of them (the de Boor triangle) and this curve stays untouched.
 	// =====================================================================================================================================
+	// t inside a uniform span: the span follows from t without a search, the point from a fixed matrix-vector product instead
+	// of the triangle. knots themselves take the general path.
+	if (uniformSpans.begin < uniformSpans.end)
+	{
+		const float offset = (t - knotVector[degree]) * uniformSpans.inverseSpacing;
+		const int k = (int)degree + (offset > 0.0f && offset < float(uniformSpans.end) ? (int)offset : 0);
+		if (uniformSpans.contains(k) && knotVector[k] < t && t < knotVector[k + 1])
+		{
+			if (!rational) return uniformSpanPoint<Vec3f>(controlPoints, knotVector, uniformSpans, t, k, (int)degree, tangent);
+			return uniformSpanPoint<Vec4f>(controlPoints, knotVector, uniformSpans, t, k, (int)degree, tangent);
+		}
+	}
 	// determine multiplicity of parameter t in U
 	int k;
 	unsigned int multiplicity = getMultiplicityAndIndex(t, k);
 	if (k == -1) return Vec4f(0.0f, 0.0f, 0.0f, 0.0f);
+	const int n = (int)controlPoints.size();
 	// special case: start of the curve
 	if (t == knotVector.front()) 
 	{
-		Vec4f& t1 = controlPoints[0];
-		Vec4f& t2 = controlPoints[1];
-		tangent = Vec4f(t1.w * t2.x - t2.w * t1.x, t1.w * t2.y - t2.w * t1.y, t1.w * t2.z - t2.w * t1.z, t1.w * t2.w);
+		tangent = homogeneousDifference(controlPoints[0], controlPoints[1]);
 		return controlPoints.front();
 	}
 	// special case: end of the curve
 	if (t == knotVector.back()) 
 	{
-		Vec4f& t1 = controlPoints[controlPoints.size() - 2];
-		Vec4f& t2 = controlPoints[controlPoints.size() - 1];
-		tangent = Vec4f(t1.w * t2.x - t2.w * t1.x, t1.w * t2.y - t2.w * t1.y, t1.w * t2.z - t2.w * t1.z, t1.w * t2.w);
+		tangent = homogeneousDifference(controlPoints[n - 2], controlPoints[n - 1]);
 		return controlPoints.back();
 	}
-	// insert knot p - multiplicity times
-	int iterations =  (int)degree - (int)multiplicity;
-	for (int i = 0; i < iterations; i++) 
+	if (degree > NURBS_MAX_DEGREE) return Vec4f(0.0f, 0.0f, 0.0f, 0.0f);
+	const int p = (int)degree;
+	if (k < p || k >= n) return Vec4f(0.0f, 0.0f, 0.0f, 0.0f);
+	// number of insertions
+	const int r = std::max(p - (int)multiplicity, 0);
+	if (r == 0)
 	{
-		tempNURBS.insertKnot(t);
+		// t already has multiplicity p, the curve point is a control point
+		tangent = homogeneousDifference(controlPoints[std::max(k - p - 1, 0)], controlPoints[std::min(k - p + 1, n - 1)]);
+		return controlPoints[k - p];
 	}
-	// extract point from the control points of tempNURBS
-	int index = tempNURBS.getIndex(t) - tempNURBS.degree;
-	// to extract the tangent, use the adjacent control points. Take care to not use the simple subtraction operation on homogene vectors!
-	Vec4f& t1 = tempNURBS.controlPoints[index-1];
-	Vec4f& t2 = tempNURBS.controlPoints[index+1];
-	tangent = Vec4f(t1.w * t2.x - t2.w * t1.x, t1.w * t2.y - t2.w * t1.y, t1.w * t2.z - t2.w * t1.z, t1.w * t2.w);
-	return tempNURBS.controlPoints[index];
+	// the weights of a polynomial curve stay 1, so they are not blended
+	if (!rational) return deBoorTriangle<Vec3f>(controlPoints, knotVector, t, k, p, r, tangent);
+	return deBoorTriangle<Vec4f>(controlPoints, knotVector, t, k, p, r, tangent);
 	// =====================================================================================================================================
 }
 
-int NURBSCurve::getIndex(const float u)
+Vec4f NURBSCurve::evaluteDeBoor(const float t) const
+{
+	Vec4f tangent;
+	return evaluteDeBoor(t, tangent);
+}
+
+int NURBSCurve::getIndex(const float u) const
 {
 	// abort if no knot vector available
 	if (knotVector.size() == 0) return -1;
@@ -126,7 +299,7 @@ int NURBSCurve::getIndex(const float u)
 	return (int)k;
 }
 
-unsigned int NURBSCurve::getMultiplicityAndIndex(const float u, int &k)
+unsigned int NURBSCurve::getMultiplicityAndIndex(const float u, int &k) const
 {
 	unsigned int multiplicity = 0;
 	k = getIndex(u);
@@ -147,26 +320,23 @@ unsigned int NURBSCurve::getMultiplicityAndIndex(const float u, int &k)
 	}
 	return multiplicity;
 }
-std::pair<std::vector<Vec4f>, std::vector<Vec4f>> NURBSCurve::evaluateCurveAt(const std::vector<float>& T)
+std::pair<std::vector<Vec4f>, std::vector<Vec4f>> NURBSCurve::evaluateCurveAt(const std::vector<float>& T) const
 {
-	std::vector<Vec4f> points;
-	points.reserve(T.size());
-	std::vector<Vec4f> tangents;
-	tangents.reserve(T.size());
-	for (auto t : T)
+	PROFILE_SCOPE("NURBSCurve::evaluateCurveAt");
+	std::vector<Vec4f> points(T.size());
+	std::vector<Vec4f> tangents(T.size());
+	// the samples are independent, evaluteDeBoor is reentrant
+	parallelFor(T.size(), 256, [&](size_t begin, size_t end)
 	{
-		Vec4f tangent;
-		auto evaluatedCurve = evaluteDeBoor(t,tangent);
-		points.push_back(evaluatedCurve);
-		tangents.push_back(tangent);
-	}
+		for (size_t i = begin; i < end; i++) points[i] = evaluteDeBoor(T[i], tangents[i]);
+	});
 	return std::pair<std::vector<Vec4f>, std::vector<Vec4f>>(points, tangents);
 }
 
-std::pair<std::vector<Vec4f>, std::vector<Vec4f>> NURBSCurve::evaluateCurveAt(const size_t numberSamples)
+std::pair<std::vector<Vec4f>, std::vector<Vec4f>> NURBSCurve::evaluateCurveAt(const size_t numberSamples) const
 {
 	std::vector<float> T;
-	float max = getKnotVector().back();
+	float max = knotVector.back();
 	T.reserve(numberSamples);
 	float deltaT = 1.0f;
 	if (numberSamples > 1) deltaT = max / (float(numberSamples) - 1.0f);
@@ -177,7 +347,244 @@ std::pair<std::vector<Vec4f>, std::vector<Vec4f>> NURBSCurve::evaluateCurveAt(co
 	return evaluateCurveAt(T);
 }
 
-std::ostream& operator<< (std::ostream& os, NURBSCurve& nurbs)
+void NURBSCurve::setKnotVector(const std::vector<float>& knotVector_)
+{
+	knotVector = knotVector_;
+	invalidateCaches();
+}
+
+void NURBSCurve::invalidateCaches()
+{
+	std::atomic_store(&arcLengthTable, std::shared_ptr<const ArcLengthTable>());
+	std::atomic_store(&polyline, std::shared_ptr<const CurvePolyline>());
+	std::atomic_store(&powerBasis, std::shared_ptr<const CurvePowerBasis>());
+	uniformSpans = findUniformKnotSpans(knotVector, degree, controlPoints.size());
+	validationResult = validateCurve(controlPoints, knotVector, degree);
+}
+
+float NURBSCurve::speedAt(const float t) const
+{
+	Vec3f derivatives[2];
+	evaluateDerivatives(t, 1, derivatives);
+	return derivatives[1].length();
+}
+
+// 5-point Gauss-Legendre quadrature of speed(t) over [a, b]
+template<class Speed>
+static float gaussLength(const Speed& speed, const float a, const float b)
+{
+	static const float nodes[5] = { 0.0f, -0.5384693101f, 0.5384693101f, -0.9061798459f, 0.9061798459f };
+	static const float weights[5] = { 0.5688888889f, 0.4786286705f, 0.4786286705f, 0.2369268851f, 0.2369268851f };
+	float center = 0.5f * (a + b);
+	float halfLength = 0.5f * (b - a);
+	float sum = 0.0f;
+	for (unsigned int i = 0; i < 5; i++) sum += weights[i] * speed(center + halfLength * nodes[i]);
+	return sum * halfLength;
+}
+
+// adaptive bisection of [a, b] until both halves agree with the whole interval. appends the end points of the accepted intervals to the table.
+template<class Speed>
+static void adaptiveArcLength(const Speed& speed, const float a, const float b, const float whole, const float tolerance, const unsigned int depth, ArcLengthTable& table)
+{
+	float m = 0.5f * (a + b);
+	float left = gaussLength(speed, a, m);
+	float right = gaussLength(speed, m, b);
+	if (depth >= 12 || (depth >= 1 && std::fabs(left + right - whole) <= tolerance))
+	{
+		float s = table.lengths.back();
+		table.parameters.push_back(m);
+		table.lengths.push_back(s + left);
+		table.parameters.push_back(b);
+		table.lengths.push_back(s + left + right);
+		return;
+	}
+	adaptiveArcLength(speed, a, m, left, 0.5f * tolerance, depth + 1, table);
+	adaptiveArcLength(speed, m, b, right, 0.5f * tolerance, depth + 1, table);
+}
+
+std::shared_ptr<const ArcLengthTable> NURBSCurve::getArcLengthTable() const
+{
+	std::shared_ptr<const ArcLengthTable> current = std::atomic_load(&arcLengthTable);
+	if (current) return current;
+	// threads racing here build equal tables, the last one stored wins
+	std::shared_ptr<ArcLengthTable> table = std::make_shared<ArcLengthTable>();
+	auto speed = [this](const float t) { return speedAt(t); };
+	table->parameters.push_back(knotVector.empty() ? 0.0f : knotVector[degree]);
+	table->lengths.push_back(0.0f);
+	// integrate every non-empty knot span separately, the speed is smooth within a span
+	for (size_t k = degree; k < controlPoints.size() && k + 1 < knotVector.size(); k++)
+	{
+		float a = knotVector[k];
+		float b = knotVector[k + 1];
+		if (b <= a) continue;
+		float whole = gaussLength(speed, a, b);
+		adaptiveArcLength(speed, a, b, whole, std::max(1e-5f * whole, 1e-7f), 0, *table);
+	}
+	std::atomic_store(&arcLengthTable, std::shared_ptr<const ArcLengthTable>(table));
+	return table;
+}
+
+float NURBSCurve::getArcLength() const
+{
+	return getArcLengthTable()->lengths.back();
+}
+
+float NURBSCurve::parameterAtArcLength(const float s) const
+{
+	std::shared_ptr<const ArcLengthTable> table = getArcLengthTable();
+	// O(log n) search for the table segment
+	size_t hint = std::upper_bound(table->lengths.begin(), table->lengths.end(), s) - table->lengths.begin();
+	hint = (hint > 0) ? hint - 1 : 0;
+	return parameterAtArcLength(*table, s, hint);
+}
+
+float NURBSCurve::parameterAtArcLength(const float s, size_t& hint) const
+{
+	return parameterAtArcLength(*getArcLengthTable(), s, hint);
+}
+
+float NURBSCurve::parameterAtArcLength(const ArcLengthTable& table, const float s, size_t& hint) const
+{
+	const std::vector<float>& lengths = table.lengths;
+	const size_t n = lengths.size();
+	if (n < 2) return table.parameters.front();
+	float length = std::min(std::max(s, 0.0f), lengths.back());
+	// try the hinted segment and its successor first, search otherwise
+	if (hint > n - 2) hint = n - 2;
+	if (!(lengths[hint] <= length && length <= lengths[hint + 1]))
+	{
+		if (hint + 2 < n && lengths[hint + 1] <= length && length <= lengths[hint + 2]) hint++;
+		else
+		{
+			hint = std::upper_bound(lengths.begin(), lengths.end(), length) - lengths.begin();
+			hint = std::min(std::max(hint, size_t(1)) - 1, n - 2);
+		}
+	}
+	// linear guess within the segment, refined by Newton iteration on s(t) - length
+	const float t0 = table.parameters[hint];
+	const float t1 = table.parameters[hint + 1];
+	const float s0 = lengths[hint];
+	const float s1 = lengths[hint + 1];
+	if (s1 <= s0) return t0;
+	auto speed = [this](const float t) { return speedAt(t); };
+	float t = t0 + (t1 - t0) * (length - s0) / (s1 - s0);
+	for (unsigned int i = 0; i < 3; i++)
+	{
+		float f = s0 + gaussLength(speed, t0, t) - length;
+		float df = speedAt(t);
+		if (df <= 1e-12f) break;
+		t = std::min(std::max(t - f / df, t0), t1);
+	}
+	return t;
+}
+
+std::pair<std::vector<Vec4f>, std::vector<Vec4f>> NURBSCurve::sampleByArcLength(const size_t numberSamples) const
+{
+	std::vector<float> T;
+	T.reserve(numberSamples);
+	// one table for all samples, even if the curve is changed meanwhile
+	std::shared_ptr<const ArcLengthTable> table = getArcLengthTable();
+	float length = table->lengths.back();
+	float deltaS = 0.0f;
+	if (numberSamples > 1) deltaS = length / (float(numberSamples) - 1.0f);
+	size_t hint = 0;
+	for (size_t i = 0; i < numberSamples; ++i)
+	{
+		T.push_back(parameterAtArcLength(*table, float(i) * deltaS, hint));
+	}
+	return evaluateCurveAt(T);
+}
+
+// distance of x to the segment [a, b]
+static float segmentDistance(const Vec3f& x, const Vec3f& a, const Vec3f& b)
+{
+	Vec3f ab = b - a;
+	float squaredLength = ab.sqlength();
+	float s = squaredLength > 0.0f ? std::min(std::max(((x - a) * ab) / squaredLength, 0.0f), 1.0f) : 0.0f;
+	return (a + ab * s - x).length();
+}
+
+// deviation of the homogeneous point x from the chord [a, b], the larger one of the homogenized and the raw x, y, z
+// (the same for polynomial curves)
+static float chordDeviation(const Vec4f& x, const Vec4f& a, const Vec4f& b, const bool rational)
+{
+	if (!rational) return segmentDistance(Vec3f(x.x, x.y, x.z), Vec3f(a.x, a.y, a.z), Vec3f(b.x, b.y, b.z));
+	Vec4f xh = x.homogenized();
+	Vec4f ah = a.homogenized();
+	Vec4f bh = b.homogenized();
+	return std::max(segmentDistance(Vec3f(xh.x, xh.y, xh.z), Vec3f(ah.x, ah.y, ah.z), Vec3f(bh.x, bh.y, bh.z)),
+		segmentDistance(Vec3f(x.x, x.y, x.z), Vec3f(a.x, a.y, a.z), Vec3f(b.x, b.y, b.z)));
+}
+
+// adaptive bisection of [a, b] until the curve point in the middle is within tolerance of the chord.
+// appends the samples after a (up to and including b) to the polyline.
+template<class Evaluate>
+static void adaptivePolyline(const Evaluate& evaluate, const float a, const Vec4f& pa, const float b, const Vec4f& pb, const Vec4f& tb, const float tolerance, const bool rational, const unsigned int depth, CurvePolyline& polyline)
+{
+	float m = 0.5f * (a + b);
+	Vec4f tm;
+	Vec4f pm = evaluate(m, tm);
+	if (depth < 12 && chordDeviation(pm, pa, pb, rational) > tolerance)
+	{
+		adaptivePolyline(evaluate, a, pa, m, pm, tm, tolerance, rational, depth + 1, polyline);
+		adaptivePolyline(evaluate, m, pm, b, pb, tb, tolerance, rational, depth + 1, polyline);
+		return;
+	}
+	polyline.parameters.push_back(b);
+	polyline.points.push_back(pb);
+	polyline.tangents.push_back(tb);
+}
+
+std::shared_ptr<const CurvePolyline> NURBSCurve::getPolyline(const float tolerance) const
+{
+	// one cache entry per power of two, so small zoom steps reuse the polyline
+	const float quantized = std::exp2(std::floor(std::log2(std::max(tolerance, 1e-6f))));
+	std::shared_ptr<const CurvePolyline> current = std::atomic_load(&polyline);
+	if (current && current->tolerance == quantized) return current;
+	// threads racing here build equal polylines (for equal tolerances), the last one stored wins
+	std::shared_ptr<CurvePolyline> result = std::make_shared<CurvePolyline>();
+	result->tolerance = quantized;
+	auto evaluate = [this](const float t, Vec4f& tangent) { return evaluteDeBoor(t, tangent); };
+	// a few segments per knot span first, so the midpoint test does not miss an inflection (e.g. an s-shaped span)
+	const unsigned int segmentsPerSpan = 4;
+	bool first = true;
+	for (size_t k = degree; k < controlPoints.size() && k + 1 < knotVector.size(); k++)
+	{
+		float a = knotVector[k];
+		float b = knotVector[k + 1];
+		if (b <= a) continue;
+		if (first)
+		{
+			Vec4f tangent;
+			result->parameters.push_back(a);
+			result->points.push_back(evaluate(a, tangent));
+			result->tangents.push_back(tangent);
+			first = false;
+		}
+		for (unsigned int s = 1; s <= segmentsPerSpan; s++)
+		{
+			// exactly b at the end of the span, so the spans join without a gap
+			const float t = (s == segmentsPerSpan) ? b : a + (b - a) * float(s) / float(segmentsPerSpan);
+			Vec4f tangent;
+			Vec4f point = evaluate(t, tangent);
+			adaptivePolyline(evaluate, result->parameters.back(), result->points.back(), t, point, tangent, quantized, rational, 0, *result);
+		}
+	}
+	std::atomic_store(&polyline, std::shared_ptr<const CurvePolyline>(result));
+	return result;
+}
+
+std::shared_ptr<const CurvePowerBasis> NURBSCurve::getPowerBasis() const
+{
+	std::shared_ptr<const CurvePowerBasis> current = std::atomic_load(&powerBasis);
+	if (current) return current;
+	// threads racing here build equal forms, the last one stored wins
+	current = std::make_shared<CurvePowerBasis>(*this);
+	std::atomic_store(&powerBasis, current);
+	return current;
+}
+
+std::ostream& operator<< (std::ostream& os, const NURBSCurve& nurbs)
 {
 	// degree
 	os << "NURBS curve, degree " << nurbs.getDegree() << "\n";
@@ -189,6 +596,6 @@ std::ostream& operator<< (std::ostream& os, NURBSCurve& nurbs)
 	for (unsigned int i = 0; i < nurbs.getKnotVector().size(); i++) os << nurbs.getKnotVector()[i] << ", ";
 	os << "\n";
 	// knot vector verification
-	nurbs.isValidNURBS();
+	os << "  " << validateCurve(nurbs.getControlPoints(), nurbs.getKnotVector(), nurbs.getDegree()) << "\n";
 	return os;
 }
\ No newline at end of file
@@ -12,9 +12,36 @@
 #define NURBS_CURVE_H
 
 #include <stdlib.h>		// standard library
+#include <memory>		// std::shared_ptr<>
 #include <vector>		// std::vector<>
 
+#include "Vec3.h"		// vector (x, y, z)
 #include "Vec4.h"		// vector (x, y, z, w)
+#include "NURBS_Basis.h"
+#include "NURBS_Validation.h"
+
+// arc length parameterization of a curve: parameters t_i and the arc lengths s_i from the curve start to t_i (both ascending)
+struct ArcLengthTable
+{
+	std::vector<float> parameters;
+	std::vector<float> lengths;
+};
+
+// adaptive polyline of a curve: ascending parameters with their (homogeneous) points and tangents. between two consecutive
+// samples the curve deviates less than tolerance from the chord, homogenized as well as in x, y, z of the homogeneous points.
+struct CurvePolyline
+{
+	float tolerance;
+	std::vector<float> parameters;
+	std::vector<Vec4f> points;
+	std::vector<Vec4f> tangents;
+
+	CurvePolyline() : tolerance(0.0f)
+	{
+	}
+};
+
+class CurvePowerBasis;	// NURBS_PowerBasis.h
 
 class NURBSCurve {
 
@@ -26,31 +53,89 @@ public:
 	// constructor which takes given control points P, knot vector U and degree p
 	NURBSCurve(const std::vector<Vec4f>& controlPoints_, const std::vector<float>& knotVector_, const unsigned int degree_);
 
+	// copies share the cached data. it is read with std::atomic_load, other threads may be building it.
+	NURBSCurve(const NURBSCurve& other);
+	NURBSCurve& operator=(const NURBSCurve& other);
+	NURBSCurve(NURBSCurve&& other) = default;
+	NURBSCurve& operator=(NURBSCurve&& other) = default;
 
 	// insert a knot with deBoor algorithm. returns false, if newKnot is not within begin and end parameter.
 	bool insertKnot(const float newKnot);
 
 	// evaluate the curve at parameter t with deBoor (inserting a knot until its multiplicity is p). also returns the tangent at the evaluated point.
-	Vec4f evaluteDeBoor(const float t, Vec4f& tangent);
+	// the knots are inserted into a local copy of the p + 1 affected control points only, so any number of threads may evaluate one curve at once.
+	// inside the uniform spans of a (clamped) uniform knot vector the same point and tangent follow from the uniform basis matrix.
+	Vec4f evaluteDeBoor(const float t, Vec4f& tangent) const;
+
+	// same as above without the tangent
+	Vec4f evaluteDeBoor(const float t) const;
+
+	// evaluate the homogenized curve and all its derivatives up to order (<= NURBS_MAX_DEGREE) at t in one pass.
+	// derivatives has to hold order + 1 entries, derivatives[k] is the k-th derivative (derivatives[0] the point itself).
+	// all entries are zero if the curve is invalid or order > NURBS_MAX_DEGREE.
+	void evaluateDerivatives(const float t, const unsigned int order, Vec3f* derivatives) const;
 
-	// returns false if the knot vector is not sorted or if the dimensions of knot vector, control points and degree do not match
-	bool isValidNURBS();
+	// same as above, resizes derivatives to order + 1 entries
+	void evaluateDerivatives(const float t, const unsigned int order, std::vector<Vec3f>& derivatives) const;
+
+	// evaluate the derivatives up to order at all parameters T. returns order + 1 entries per parameter, ordered like T.
+	std::vector<Vec3f> evaluateDerivativesAt(const std::vector<float>& T, const unsigned int order) const;
+
+	// returns false if the knot vector is not sorted or if the dimensions of knot vector, control points and degree do not match.
+	// the result is cached by the constructors and revalidated whenever the curve changes.
+	bool isValidNURBS() const;
+
+	// returns the cached validation result
+	const NURBSValidation& validation() const { return validationResult; }
 
 	// getting references to the control points
 	const std::vector<Vec4f>& getControlPoints() const { return controlPoints; }
 
 	// getting reference to knot vector
-	std::vector<float>& getKnotVector() { return knotVector; }
+	const std::vector<float>& getKnotVector() const { return knotVector; }
+
+	// replaces the knot vector (same number of knots to keep the curve valid) and drops all cached data
+	void setKnotVector(const std::vector<float>& knotVector_);
 
 	// getting degree
-	unsigned int getDegree() { return degree; }
+	unsigned int getDegree() const { return degree; }
+
+	// false if all weights are 1. the evaluation of such polynomial curves skips the weights and the division by w.
+	bool isRational() const { return rational; }
 
 
 	// evaluate the curve at parameters T with deBoor.  Returns the evaluated points and their tangents.
-	std::pair<std::vector<Vec4f>, std::vector<Vec4f>> evaluateCurveAt(const std::vector<float>& T);
+	std::pair<std::vector<Vec4f>, std::vector<Vec4f>> evaluateCurveAt(const std::vector<float>& T) const;
 
 	// evaluate the curve with deBoor algorithm at numberSamples sample points. Returns the evaluated points and their tangents.
-	std::pair<std::vector<Vec4f>, std::vector<Vec4f>> evaluateCurveAt(const size_t numberSamples);
+	std::pair<std::vector<Vec4f>, std::vector<Vec4f>> evaluateCurveAt(const size_t numberSamples) const;
+
+
+	// returns the arc length table of the (homogenized) curve. it is built on first use and shared by all threads until the
+	// curve changes (like getPowerBasis).
+	std::shared_ptr<const ArcLengthTable> getArcLengthTable() const;
+
+	// returns the total arc length of the (homogenized) curve
+	float getArcLength() const;
+
+	// returns the parameter t at arc length s (clamped to [0, getArcLength()]). O(log n) search in the arc length table.
+	float parameterAtArcLength(const float s) const;
+
+	// returns the parameter t at arc length s. the search starts at table entry hint which is updated to the found entry,
+	// so ascending (or nearby) queries take O(1).
+	float parameterAtArcLength(const float s, size_t& hint) const;
+
+	// evaluate the curve at numberSamples points with equal arc length spacing. Returns the evaluated points and their tangents.
+	std::pair<std::vector<Vec4f>, std::vector<Vec4f>> sampleByArcLength(const size_t numberSamples) const;
+
+	// returns the adaptive polyline with chord deviation below tolerance. it is cached for the tolerance rounded down to a
+	// power of two (zooming by less than a factor of two reuses it) until the curve changes. the cache is shared by all
+	// threads like the arc length table, the returned polyline stays valid after the curve changes.
+	std::shared_ptr<const CurvePolyline> getPolyline(const float tolerance) const;
+
+	// returns the power basis form of the curve for fast repeated evaluation (see NURBS_PowerBasis.h). it is built on
+	// first use and shared by all threads until the curve changes, an invalid curve gives an empty form.
+	std::shared_ptr<const CurvePowerBasis> getPowerBasis() const;
 
 private:
 
@@ -58,16 +143,34 @@ private:
 	std::vector<Vec4f> controlPoints;
 	std::vector<float> knotVector;
 	unsigned int degree;
+	bool rational;		// some weight differs from 1 (set by the constructor, knot insertion keeps it)
+	UniformKnotSpans uniformSpans;	// spans evaluated with the uniform basis matrix (set by the constructor and invalidateCaches())
+
+	// cached data derived from the geometry (shared between copies, rebuilt after changes). only accessed through
+	// std::atomic_load / std::atomic_store.
+	mutable std::shared_ptr<const ArcLengthTable> arcLengthTable;	// built by getArcLengthTable()
+	mutable std::shared_ptr<const CurvePolyline> polyline;		// built by getPolyline()
+	mutable std::shared_ptr<const CurvePowerBasis> powerBasis;	// built by getPowerBasis()
+	NURBSValidation validationResult;
+
+	// drop all cached data, revalidate and detect the uniform spans again. has to be called whenever control points or knot vector change.
+	void invalidateCaches();
+
+	// returns the speed |C'(t)| of the homogenized curve
+	float speedAt(const float t) const;
+
+	// parameterAtArcLength on the given table
+	float parameterAtArcLength(const ArcLengthTable& table, const float s, size_t& hint) const;
 
 	// find the index k in knot vector with u in [u_k, u_k+1). returns -1 on error.
-	int getIndex(const float u);
+	int getIndex(const float u) const;
 
 	// returns the multiplicity of knot u. returns 0 if u not in U. also returns index k so that u in [u_k, u_k+1)
-	unsigned int getMultiplicityAndIndex(const float u, int &k);
+	unsigned int getMultiplicityAndIndex(const float u, int &k) const;
 
 };
 
 // ostream << operator. E.g. use "std::cout << nurbs << std::endl;"
-std::ostream& operator<< (std::ostream& os, NURBSCurve& nurbsCurve);
+std::ostream& operator<< (std::ostream& os, const NURBSCurve& nurbsCurve);
 
 #endif // NURBS_CURVE_H
\ No newline at end of file
@@ -0,0 +1,116 @@
+#include "NURBS_CurveSet.h"
+
+#include "NURBS_Basis.h"
+#include "Parallel.h"
+#include "Profiler.h"
+
+// curves blended per task when a single parameter is evaluated
+static const size_t CURVE_GRAIN = 4096;
+
+// result[c] += factor * values[c]. four curves per iteration, so the compiler packs them into one vector multiply-add
+// even where it does not vectorize loops (gcc -O2).
+static void multiplyAdd(float* __restrict result, const float* __restrict values, const float factor, const size_t count)
+{
+	size_t c = 0;
+	for (; c + 4 <= count; c += 4)
+	{
+		result[c] += factor * values[c];
+		result[c + 1] += factor * values[c + 1];
+		result[c + 2] += factor * values[c + 2];
+		result[c + 3] += factor * values[c + 3];
+	}
+	for (; c < count; c++) result[c] += factor * values[c];
+}
+
+static void resizePoints(CurveSetPoints& points, const size_t count)
+{
+	points.x.assign(count, 0.0f);
+	points.y.assign(count, 0.0f);
+	points.z.assign(count, 0.0f);
+	points.w.assign(count, 0.0f);
+}
+
+NURBSCurveSet::NURBSCurveSet(const std::vector<float>& knotVector_, const unsigned int degree_, const size_t numControlPoints_)
+	: knotVector(knotVector_)
+	, degree(degree_)
+	, numControlPoints(numControlPoints_)
+	, numCurves(0)
+	, coordinates(4 * numControlPoints_)
+	, validationResult(validateKnotVector(knotVector_, numControlPoints_, degree_))
+	, uniformSpans(findUniformKnotSpans(knotVector_, degree_, numControlPoints_))
+{
+}
+
+bool NURBSCurveSet::addCurve(const std::vector<Vec4f>& controlPoints)
+{
+	if (controlPoints.size() != numControlPoints) return false;
+	for (size_t i = 0; i < numControlPoints; i++)
+	{
+		coordinates[4 * i + 0].push_back(controlPoints[i].x);
+		coordinates[4 * i + 1].push_back(controlPoints[i].y);
+		coordinates[4 * i + 2].push_back(controlPoints[i].z);
+		coordinates[4 * i + 3].push_back(controlPoints[i].w);
+	}
+	numCurves++;
+	return true;
+}
+
+Vec4f NURBSCurveSet::getControlPoint(const size_t c, const size_t i) const
+{
+	return Vec4f(coordinates[4 * i][c], coordinates[4 * i + 1][c], coordinates[4 * i + 2][c], coordinates[4 * i + 3][c]);
+}
+
+NURBSCurve NURBSCurveSet::getCurve(const size_t c) const
+{
+	std::vector<Vec4f> controlPoints(numControlPoints);
+	for (size_t i = 0; i < numControlPoints; i++) controlPoints[i] = getControlPoint(c, i);
+	return NURBSCurve(controlPoints, knotVector, degree);
+}
+
+void NURBSCurveSet::blend(const int span, const float* N, const size_t begin, const size_t end, CurveSetPoints& result) const
+{
+	float* components[4] = { result.x.data(), result.y.data(), result.z.data(), result.w.data() };
+	for (unsigned int k = 0; k <= degree; k++)
+	{
+		const size_t i = span - degree + k;
+		for (unsigned int component = 0; component < 4; component++)
+			multiplyAdd(components[component] + begin, coordinates[4 * i + component].data() + begin, N[k], end - begin);
+	}
+}
+
+bool NURBSCurveSet::evaluateAt(const float t, CurveSetPoints& points, CurveSetPoints* derivatives /*= nullptr*/) const
+{
+	PROFILE_SCOPE("NURBSCurveSet::evaluateAt");
+	if (!isValidNURBS()) return false;
+	// span and basis functions once for all curves
+	float N[2 * (NURBS_MAX_DEGREE + 1)];
+	const int span = findSpan(knotVector, degree, numControlPoints, t);
+	basisFunctionDerivatives(knotVector, uniformSpans, degree, span, t, derivatives ? 1 : 0, N);
+	resizePoints(points, numCurves);
+	if (derivatives) resizePoints(*derivatives, numCurves);
+	parallelFor(numCurves, CURVE_GRAIN, [&](size_t begin, size_t end)
+	{
+		blend(span, N, begin, end, points);
+		if (derivatives) blend(span, N + degree + 1, begin, end, *derivatives);
+	});
+	return true;
+}
+
+bool NURBSCurveSet::evaluateAt(const std::vector<float>& T, std::vector<CurveSetPoints>& points) const
+{
+	PROFILE_SCOPE("NURBSCurveSet::evaluateAt (batch)");
+	if (!isValidNURBS()) return false;
+	points.resize(T.size());
+	parallelFor(T.size(), 1, [&](size_t begin, size_t end)
+	{
+		float N[NURBS_MAX_DEGREE + 1];
+		for (size_t j = begin; j < end; j++)
+		{
+			const int span = findSpan(knotVector, degree, numControlPoints, T[j]);
+			basisFunctionDerivatives(knotVector, uniformSpans, degree, span, T[j], 0, N);
+			resizePoints(points[j], numCurves);
+			blend(span, N, 0, numCurves, points[j]);
+		}
+	});
+	return true;
+}
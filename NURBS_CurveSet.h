@@ -0,0 +1,83 @@
+#ifndef NURBS_CURVE_SET_H
+#define NURBS_CURVE_SET_H
+
+#include <stdlib.h>			// standard library
+#include <vector>			// std::vector<>
+
+#include "NURBS_Curve.h"
+#include "NURBS_Validation.h"
+#include "Vec3.h"
+#include "Vec4.h"
+
+// homogeneous points (or derivatives) of all curves of a set at one parameter. component-major: x[c], y[c], z[c], w[c] belong to curve c.
+struct CurveSetPoints
+{
+	std::vector<float> x;
+	std::vector<float> y;
+	std::vector<float> z;
+	std::vector<float> w;
+
+	size_t size() const { return x.size(); }
+
+	// homogeneous point of curve c
+	Vec4f operator[](const size_t c) const { return Vec4f(x[c], y[c], z[c], w[c]); }
+
+	// homogenized point of curve c
+	Vec3f homogenized(const size_t c) const { return Vec3f(x[c] / w[c], y[c] / w[c], z[c] / w[c]); }
+};
+
+// many curves of the same degree and knot vector (hair strands, sweep profiles). the control points are stored point-major:
+// component k of control point i of all curves is one contiguous array. an evaluation finds the span and the basis functions
+// once and blends p + 1 of these arrays with a multiply-add loop over all curves, so it costs curves * (p + 1) multiply-adds
+// per component instead of one de Boor evaluation per curve.
+class NURBSCurveSet
+{
+
+public:
+
+	// an empty set of curves with numControlPoints control points each
+	NURBSCurveSet(const std::vector<float>& knotVector_, const unsigned int degree_, const size_t numControlPoints_);
+
+	// appends a curve. returns false (and ignores it) if it does not have getNumControlPoints() control points.
+	bool addCurve(const std::vector<Vec4f>& controlPoints);
+
+	// number of curves
+	size_t size() const { return numCurves; }
+
+	size_t getNumControlPoints() const { return numControlPoints; }
+	const std::vector<float>& getKnotVector() const { return knotVector; }
+	unsigned int getDegree() const { return degree; }
+
+	// knot vector and degree fit the number of control points
+	bool isValidNURBS() const { return validationResult.isValid(); }
+	const NURBSValidation& validation() const { return validationResult; }
+
+	// control point i of curve c
+	Vec4f getControlPoint(const size_t c, const size_t i) const;
+
+	// copy of curve c as a single curve
+	NURBSCurve getCurve(const size_t c) const;
+
+	// evaluate all curves at t: homogeneous points and, if derivatives is not nullptr, the first derivatives of the
+	// homogeneous curves. large sets are split into parallel tasks. returns false if the set is not valid.
+	bool evaluateAt(const float t, CurveSetPoints& points, CurveSetPoints* derivatives = nullptr) const;
+
+	// evaluate all curves at all parameters T (points[i] for T[i]), in parallel over the parameters
+	bool evaluateAt(const std::vector<float>& T, std::vector<CurveSetPoints>& points) const;
+
+private:
+
+	// blend the control points of curves [begin, end) with the basis values N of span
+	void blend(const int span, const float* N, const size_t begin, const size_t end, CurveSetPoints& result) const;
+
+	std::vector<float> knotVector;
+	unsigned int degree;
+	size_t numControlPoints;
+	size_t numCurves;
+	std::vector<std::vector<float>> coordinates;	// coordinates[4 * i + k][c]: component k (x, y, z, w) of control point i of curve c
+	NURBSValidation validationResult;
+	UniformKnotSpans uniformSpans;		// spans evaluated with the uniform basis matrix
+
+};
+
+#endif // NURBS_CURVE_SET_H
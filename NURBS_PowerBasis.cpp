@@ -0,0 +1,269 @@
+#include "NURBS_PowerBasis.h"
+
+#include <algorithm>	// std::upper_bound, std::max
+#include <cmath>		// sqrt
+
+#include "NURBS_Basis.h"
+#include "Parallel.h"
+#include "Profiler.h"
+
+// samples evaluated per task of the grid evaluation
+static const size_t GRID_GRAIN = 1024;
+
+// the non-empty knot spans of the parameter range [u_p, u_n]: their knot span index, bounds and centers
+static void collectSpans(const std::vector<float>& knotVector, const unsigned int p, const size_t numControlPoints,
+	std::vector<int>& spans, std::vector<float>& breakpoints, std::vector<float>& centers)
+{
+	for (size_t k = p; k < numControlPoints; k++)
+	{
+		if (knotVector[k] >= knotVector[k + 1]) continue;
+		if (breakpoints.empty()) breakpoints.push_back(knotVector[k]);
+		breakpoints.push_back(knotVector[k + 1]);
+		centers.push_back(0.5f * (knotVector[k] + knotVector[k + 1]));
+		spans.push_back((int)k);
+	}
+}
+
+// index of the span of breakpoints containing t, the ends of the range extend the first and last span
+static size_t findBreakpointSpan(const std::vector<float>& breakpoints, const float t)
+{
+	if (breakpoints.size() < 3) return 0;
+	return std::upper_bound(breakpoints.begin() + 1, breakpoints.end() - 1, t) - (breakpoints.begin() + 1);
+}
+
+// same as above, tries span first (the span of the previous query)
+static size_t findBreakpointSpan(const std::vector<float>& breakpoints, const float t, const size_t span)
+{
+	if (span + 2 < breakpoints.size() && t >= breakpoints[span] && t < breakpoints[span + 1]) return span;
+	return findBreakpointSpan(breakpoints, t);
+}
+
+// Taylor coefficients of the p + 1 basis functions of span at center: M[j * (p + 1) + i] = N_i^(j)(center) / j!
+static void powerCoefficients(const std::vector<float>& knotVector, const unsigned int p, const int span, const float center, float* M)
+{
+	basisFunctionDerivatives(knotVector, p, span, center, p, M);
+	float factorial = 1.0f;
+	for (unsigned int j = 2; j <= p; j++)
+	{
+		factorial *= float(j);
+		for (unsigned int i = 0; i <= p; i++) M[j * (p + 1) + i] /= factorial;
+	}
+}
+
+// Horner's scheme for sum_j a[j * stride] s^j (j = 0 .. p). every step is one Vec4f multiplyAdd, a single (fused) vector
+// instruction on SSE / NEON.
+static inline Vec4f horner(const Vec4f* a, const size_t stride, const unsigned int p, const float s)
+{
+	Vec4f value = a[p * stride];
+	for (int j = (int)p - 1; j >= 0; j--) value = multiplyAdd(value, s, a[j * stride]);
+	return value;
+}
+
+// same as above, also returns the derivative d/ds
+static inline Vec4f horner(const Vec4f* a, const size_t stride, const unsigned int p, const float s, Vec4f& derivative)
+{
+	Vec4f value = a[p * stride];
+	derivative = Vec4f();
+	for (int j = (int)p - 1; j >= 0; j--)
+	{
+		derivative = multiplyAdd(derivative, s, value);
+		value = multiplyAdd(value, s, a[j * stride]);
+	}
+	return value;
+}
+
+CurvePowerBasis::CurvePowerBasis() : degree(0)
+{
+}
+
+CurvePowerBasis::CurvePowerBasis(const NURBSCurve& curve) : degree(curve.getDegree())
+{
+	if (!curve.isValidNURBS()) return;
+	const unsigned int p = degree;
+	const std::vector<Vec4f>& controlPoints = curve.getControlPoints();
+	const std::vector<float>& knotVector = curve.getKnotVector();
+	std::vector<int> spans;
+	collectSpans(knotVector, p, controlPoints.size(), spans, breakpoints, centers);
+	coefficients.resize(spans.size() * (p + 1));
+	float M[(NURBS_MAX_DEGREE + 1) * (NURBS_MAX_DEGREE + 1)];
+	for (size_t s = 0; s < spans.size(); s++)
+	{
+		powerCoefficients(knotVector, p, spans[s], centers[s], M);
+		for (unsigned int j = 0; j <= p; j++)
+			for (unsigned int i = 0; i <= p; i++) coefficients[s * (p + 1) + j] += controlPoints[spans[s] - p + i] * M[j * (p + 1) + i];
+	}
+}
+
+size_t CurvePowerBasis::spanOf(const float t) const
+{
+	return findBreakpointSpan(breakpoints, t);
+}
+
+Vec4f CurvePowerBasis::evaluate(const float t, Vec4f& derivative) const
+{
+	if (centers.empty())
+	{
+		derivative = Vec4f();
+		return Vec4f();
+	}
+	const size_t span = spanOf(t);
+	return horner(&coefficients[span * (degree + 1)], 1, degree, t - centers[span], derivative);
+}
+
+Vec4f CurvePowerBasis::evaluate(const float t) const
+{
+	if (centers.empty()) return Vec4f();
+	const size_t span = spanOf(t);
+	return horner(&coefficients[span * (degree + 1)], 1, degree, t - centers[span]);
+}
+
+void CurvePowerBasis::evaluate(const std::vector<float>& T, Vec4f* points, Vec4f* derivatives /*= nullptr*/) const
+{
+	PROFILE_SCOPE("CurvePowerBasis::evaluate");
+	if (centers.empty())
+	{
+		std::fill(points, points + T.size(), Vec4f());
+		if (derivatives) std::fill(derivatives, derivatives + T.size(), Vec4f());
+		return;
+	}
+	size_t span = 0;
+	for (size_t i = 0; i < T.size(); i++)
+	{
+		span = findBreakpointSpan(breakpoints, T[i], span);
+		const Vec4f* a = &coefficients[span * (degree + 1)];
+		const float s = T[i] - centers[span];
+		if (derivatives) points[i] = horner(a, 1, degree, s, derivatives[i]);
+		else points[i] = horner(a, 1, degree, s);
+	}
+}
+
+SurfacePowerBasis::SurfacePowerBasis(const NURBS_Surface& surface) : degree(surface.degree), rational(surface.isRational())
+{
+	if (!surface.isValidNURBS()) return;
+	const unsigned int p = degree;
+	const std::vector<std::vector<Vec4f>>& controlPoints = surface.controlPoints;
+	std::vector<int> spansU, spansV;
+	collectSpans(surface.knotVectorU, p, controlPoints[0].size(), spansU, breakpointsU, centersU);
+	collectSpans(surface.knotVectorV, p, controlPoints.size(), spansV, breakpointsV, centersV);
+	coefficients.resize(spansU.size() * spansV.size() * (p + 1) * (p + 1));
+	float Mu[(NURBS_MAX_DEGREE + 1) * (NURBS_MAX_DEGREE + 1)];
+	float Mv[(NURBS_MAX_DEGREE + 1) * (NURBS_MAX_DEGREE + 1)];
+	Vec4f rows[(NURBS_MAX_DEGREE + 1) * (NURBS_MAX_DEGREE + 1)];
+	for (size_t su = 0; su < spansU.size(); su++)
+	{
+		powerCoefficients(surface.knotVectorU, p, spansU[su], centersU[su], Mu);
+		for (size_t sv = 0; sv < spansV.size(); sv++)
+		{
+			powerCoefficients(surface.knotVectorV, p, spansV[sv], centersV[sv], Mv);
+			// the p + 1 control rows of the patch in power basis in u: rows[i * (p + 1) + r] = sum_c Mu[i][c] * P[r][c]
+			for (unsigned int i = 0; i <= p; i++)
+			{
+				for (unsigned int r = 0; r <= p; r++)
+				{
+					const Vec4f* row = &controlPoints[spansV[sv] - p + r][spansU[su] - p];
+					Vec4f sum;
+					for (unsigned int c = 0; c <= p; c++) sum += row[c] * Mu[i * (p + 1) + c];
+					rows[i * (p + 1) + r] = sum;
+				}
+			}
+			// then in v: a_ij = sum_r Mv[j][r] * rows[i][r]
+			Vec4f* a = &coefficients[(sv * spansU.size() + su) * (p + 1) * (p + 1)];
+			for (unsigned int i = 0; i <= p; i++)
+				for (unsigned int j = 0; j <= p; j++)
+					for (unsigned int r = 0; r <= p; r++) a[i * (p + 1) + j] += rows[i * (p + 1) + r] * Mv[j * (p + 1) + r];
+		}
+	}
+}
+
+Vec4f SurfacePowerBasis::evaluate(const float u, const float v, Vec4f& derivativeU, Vec4f& derivativeV) const
+{
+	if (coefficients.empty())
+	{
+		derivativeU = Vec4f();
+		derivativeV = Vec4f();
+		return Vec4f();
+	}
+	const unsigned int p = degree;
+	const size_t spanU = findBreakpointSpan(breakpointsU, u);
+	const size_t spanV = findBreakpointSpan(breakpointsV, v);
+	const Vec4f* a = patch(spanU, spanV);
+	// collapse the patch in u to a curve in v and its derivative in u
+	Vec4f c[NURBS_MAX_DEGREE + 1];
+	Vec4f cu[NURBS_MAX_DEGREE + 1];
+	for (unsigned int j = 0; j <= p; j++) c[j] = horner(a + j, p + 1, p, u - centersU[spanU], cu[j]);
+	const float r = v - centersV[spanV];
+	derivativeU = horner(cu, 1, p, r);
+	return horner(c, 1, p, r, derivativeV);
+}
+
+// the point, partial derivatives and normal of the homogeneous sample (A, Au, Av), stored at index n of buffers
+static void storeSample(const Vec4f& A, const Vec4f& Au, const Vec4f& Av, const bool rational, const size_t n, const SurfaceSampleBuffers& buffers)
+{
+	Vec3f S(A.x, A.y, A.z);
+	Vec3f Su(Au.x, Au.y, Au.z);
+	Vec3f Sv(Av.x, Av.y, Av.z);
+	if (rational)
+	{
+		const float inverseWeight = 1.0f / A.w;
+		S *= inverseWeight;
+		Su = (Su - S * Au.w) * inverseWeight;
+		Sv = (Sv - S * Av.w) * inverseWeight;
+	}
+	if (buffers.points) buffers.points[n] = S;
+	if (buffers.tangentsU) buffers.tangentsU[n] = Su;
+	if (buffers.tangentsV) buffers.tangentsV[n] = Sv;
+	if (buffers.normals)
+	{
+		const Vec3f normal = Su ^ Sv;
+		const float squaredLength = normal.sqlength();
+		buffers.normals[n] = squaredLength > 1e-20f ? normal / std::sqrt(squaredLength) : Vec3f();
+	}
+}
+
+void SurfacePowerBasis::evaluateGrid(const std::vector<float>& U, const std::vector<float>& V, const SurfaceSampleBuffers& buffers) const
+{
+	PROFILE_SCOPE("SurfacePowerBasis::evaluateGrid");
+	const unsigned int p = degree;
+	const size_t numPointsV = V.size();
+	if (coefficients.empty())
+	{
+		for (size_t n = 0; n < U.size() * numPointsV; n++) storeSample(Vec4f(), Vec4f(), Vec4f(), false, n, buffers);
+		return;
+	}
+	// span and local parameter of every V[j]
+	std::vector<size_t> spansV(numPointsV);
+	std::vector<float> localV(numPointsV);
+	size_t span = 0;
+	for (size_t j = 0; j < numPointsV; j++)
+	{
+		span = spansV[j] = findBreakpointSpan(breakpointsV, V[j], span);
+		localV[j] = V[j] - centersV[span];
+	}
+	const size_t numSpansV = centersV.size();
+	// whole grid rows per task, at least GRID_GRAIN samples
+	parallelFor(U.size(), std::max(GRID_GRAIN / std::max(numPointsV, size_t(1)), size_t(1)), [&](size_t begin, size_t end)
+	{
+		// the patches of the u span of U[i] collapsed to curves in v: c for the point, cu for the derivative in u
+		std::vector<Vec4f> c(numSpansV * (p + 1));
+		std::vector<Vec4f> cu(numSpansV * (p + 1));
+		size_t spanU = 0;
+		for (size_t i = begin; i < end; i++)
+		{
+			spanU = findBreakpointSpan(breakpointsU, U[i], spanU);
+			const float s = U[i] - centersU[spanU];
+			for (size_t sv = 0; sv < numSpansV; sv++)
+			{
+				const Vec4f* a = patch(spanU, sv);
+				for (unsigned int j = 0; j <= p; j++) c[sv * (p + 1) + j] = horner(a + j, p + 1, p, s, cu[sv * (p + 1) + j]);
+			}
+			for (size_t j = 0; j < numPointsV; j++)
+			{
+				const size_t offset = spansV[j] * (p + 1);
+				Vec4f Av;
+				const Vec4f A = horner(&c[offset], 1, p, localV[j], Av);
+				const Vec4f Au = horner(&cu[offset], 1, p, localV[j]);
+				storeSample(A, Au, Av, rational, i * numPointsV + j, buffers);
+			}
+		}
+	});
+}
@@ -0,0 +1,88 @@
+#ifndef NURBS_POWER_BASIS_H
+#define NURBS_POWER_BASIS_H
+
+#include <stdlib.h>			// standard library
+#include <vector>			// std::vector<>
+
+#include "NURBS_Curve.h"
+#include "NURBS_Surface.h"
+#include "Vec4.h"
+
+// power basis form of a curve: on every non-empty knot span the homogeneous curve is the polynomial
+// C(t) = sum_j a_j s^j in the local parameter s = t - (center of the span). an evaluation finds the span with a binary
+// search and runs Horner's scheme on the p + 1 coefficients, p multiply-adds per component and no division.
+// the form is a snapshot of the curve, build it once for geometry which is evaluated much more often than edited
+// (NURBSCurve::getPowerBasis caches it until the curve changes).
+class CurvePowerBasis
+{
+
+public:
+
+	// empty form, every evaluation returns zero
+	CurvePowerBasis();
+
+	// converts every span of curve. an invalid curve gives the empty form.
+	explicit CurvePowerBasis(const NURBSCurve& curve);
+
+	unsigned int getDegree() const { return degree; }
+	size_t getNumSpans() const { return centers.size(); }
+
+	// index of the span containing t, t is clamped to the parameter range
+	size_t spanOf(const float t) const;
+
+	// homogeneous point at t and the first derivative of the homogeneous curve
+	Vec4f evaluate(const float t, Vec4f& derivative) const;
+
+	// homogeneous point at t
+	Vec4f evaluate(const float t) const;
+
+	// homogeneous points (and derivatives, if not nullptr) at all parameters T, entry i for T[i]. the span search starts
+	// at the span of the previous parameter, so ascending parameters take O(1) per query.
+	void evaluate(const std::vector<float>& T, Vec4f* points, Vec4f* derivatives = nullptr) const;
+
+private:
+
+	unsigned int degree;
+	std::vector<float> breakpoints;		// distinct knots bounding the spans, getNumSpans() + 1 ascending values
+	std::vector<float> centers;			// expansion point of every span
+	std::vector<Vec4f> coefficients;	// coefficients[span * (degree + 1) + j] = a_j
+
+};
+
+// power basis form of a surface: on every patch (pair of non-empty knot spans) the homogeneous surface is the polynomial
+// S(u, v) = sum_i sum_j a_ij s^i r^j with s, r relative to the patch center. see CurvePowerBasis.
+class SurfacePowerBasis
+{
+
+public:
+
+	// converts every patch of surface. an invalid surface gives the empty form.
+	explicit SurfacePowerBasis(const NURBS_Surface& surface);
+
+	unsigned int getDegree() const { return degree; }
+	bool isRational() const { return rational; }
+
+	// homogeneous point at (u, v) and its partial derivatives
+	Vec4f evaluate(const float u, const float v, Vec4f& derivativeU, Vec4f& derivativeV) const;
+
+	// points, partial derivatives and normals on the grid U x V into buffers, entry i * V.size() + j holds (U[i], V[j]) like
+	// NURBS_Surface::evaluateSurfaceAtGrid. every U[i] collapses the patches of its u span to curves in v once, the samples
+	// of the row then cost three Horner evaluations of degree p.
+	void evaluateGrid(const std::vector<float>& U, const std::vector<float>& V, const SurfaceSampleBuffers& buffers) const;
+
+private:
+
+	unsigned int degree;
+	bool rational;
+	std::vector<float> breakpointsU;
+	std::vector<float> breakpointsV;
+	std::vector<float> centersU;
+	std::vector<float> centersV;
+	std::vector<Vec4f> coefficients;	// (degree + 1)^2 per patch, patch spanV * centersU.size() + spanU, then a_ij at i * (degree + 1) + j
+
+	// first coefficient of a patch
+	const Vec4f* patch(const size_t spanU, const size_t spanV) const { return &coefficients[(spanV * centersU.size() + spanU) * (degree + 1) * (degree + 1)]; }
+
+};
+
+#endif // NURBS_POWER_BASIS_H
@@ -0,0 +1,370 @@
+#include "NURBS_Projection.h"
+
+#include <algorithm>	// std::min, std::max
+#include <cmath>		// sqrt, cbrt
+#include <limits>		// std::numeric_limits
+
+#include "Parallel.h"
+
+// ================
+// === SEEDING ===
+// ================
+
+// parameters of samplesPerSpan samples in every non-empty knot span plus the end of the parameter range
+static std::vector<float> seedParameters(const std::vector<float>& knotVector, const unsigned int degree, const size_t numControlPoints, const unsigned int samplesPerSpan)
+{
+	std::vector<float> parameters;
+	const unsigned int samples = std::max(1u, samplesPerSpan);
+	for (size_t k = degree; k < numControlPoints; k++)
+	{
+		float begin = knotVector[k];
+		float end = knotVector[k + 1];
+		if (end <= begin) continue;
+		for (unsigned int s = 0; s < samples; s++) parameters.push_back(begin + (end - begin) * float(s) / float(samples));
+	}
+	parameters.push_back(knotVector[numControlPoints]);
+	return parameters;
+}
+
+// no samples for an invalid surface
+static std::vector<Vec3f> surfaceSamples(const NURBS_Surface& surface, const ProjectionSettings& settings, std::vector<float>& sampleU, std::vector<float>& sampleV)
+{
+	if (!surface.isValidNURBS()) return std::vector<Vec3f>();
+	std::vector<float> paramsU = seedParameters(surface.knotVectorU, surface.degree, surface.controlPoints[0].size(), settings.samplesPerSpan);
+	std::vector<float> paramsV = seedParameters(surface.knotVectorV, surface.degree, surface.controlPoints.size(), settings.samplesPerSpan);
+	std::vector<Vec3f> samples;
+	samples.reserve(paramsU.size() * paramsV.size());
+	for (auto u : paramsU)
+	{
+		for (auto v : paramsV)
+		{
+			Vec3f S;
+			surface.evaluateDerivatives(u, v, 0, &S);
+			samples.push_back(S);
+			sampleU.push_back(u);
+			sampleV.push_back(v);
+		}
+	}
+	return samples;
+}
+
+// no samples for an invalid curve
+static std::vector<Vec3f> curveSamples(const NURBSCurve& curve, const ProjectionSettings& settings, std::vector<float>& sampleT)
+{
+	if (!curve.isValidNURBS()) return std::vector<Vec3f>();
+	sampleT = seedParameters(curve.getKnotVector(), curve.getDegree(), curve.getControlPoints().size(), settings.samplesPerSpan);
+	std::vector<Vec3f> samples;
+	samples.reserve(sampleT.size());
+	for (auto t : sampleT)
+	{
+		Vec3f C;
+		curve.evaluateDerivatives(t, 0, &C);
+		samples.push_back(C);
+	}
+	return samples;
+}
+
+// ====================
+// === SAMPLE INDEX ===
+// ====================
+
+SampleIndex::SampleIndex(const std::vector<Vec3f>& samples_)
+	: samples(samples_)
+	, cellSize(1.0f)
+{
+	dims[0] = dims[1] = dims[2] = 1;
+	if (samples.empty())
+	{
+		cellStart.assign(2, 0);
+		return;
+	}
+	// bounding box
+	minCorner = samples[0];
+	maxCorner = samples[0];
+	for (auto& s : samples)
+	{
+		for (unsigned int a = 0; a < 3; a++)
+		{
+			minCorner[a] = std::min(minCorner[a], s[a]);
+			maxCorner[a] = std::max(maxCorner[a], s[a]);
+		}
+	}
+	// about two samples per cell on a surface-like sample set
+	Vec3f extent = maxCorner - minCorner;
+	float maxExtent = std::max(extent.x, std::max(extent.y, extent.z));
+	float cellsPerAxis = std::max(1.0f, std::floor(std::cbrt(float(samples.size()))));
+	cellSize = maxExtent > 0.0f ? maxExtent / cellsPerAxis : 1.0f;
+	for (unsigned int a = 0; a < 3; a++) dims[a] = std::max(1, (int)std::ceil(extent[a] / cellSize));
+	// counting sort of the samples into the cells
+	const size_t numCells = size_t(dims[0]) * dims[1] * dims[2];
+	std::vector<size_t> cellOfSample(samples.size());
+	cellStart.assign(numCells + 1, 0);
+	for (size_t i = 0; i < samples.size(); i++)
+	{
+		const Vec3f& s = samples[i];
+		size_t cell = (size_t(cellCoordinate(s.z, 2)) * dims[1] + cellCoordinate(s.y, 1)) * dims[0] + cellCoordinate(s.x, 0);
+		cellOfSample[i] = cell;
+		cellStart[cell + 1]++;
+	}
+	for (size_t c = 0; c < numCells; c++) cellStart[c + 1] += cellStart[c];
+	std::vector<size_t> fill(cellStart.begin(), cellStart.end() - 1);
+	cellSamples.resize(samples.size());
+	for (size_t i = 0; i < samples.size(); i++) cellSamples[fill[cellOfSample[i]]++] = i;
+}
+
+int SampleIndex::cellCoordinate(const float x, const int axis) const
+{
+	int c = (int)((x - minCorner[axis]) / cellSize);
+	return std::min(std::max(c, 0), dims[axis] - 1);
+}
+
+size_t SampleIndex::nearest(const Vec3f& q) const
+{
+	// search rings of cells around the cell containing q (clamped to the grid).
+	// clamping to the bounding box never increases distances to samples, so after ring r
+	// all remaining samples are at least r * cellSize away from q.
+	int c[3] = { cellCoordinate(q.x, 0), cellCoordinate(q.y, 1), cellCoordinate(q.z, 2) };
+	const int maxRing = std::max(dims[0], std::max(dims[1], dims[2]));
+	float bestDistance = std::numeric_limits<float>::max();
+	size_t best = 0;
+	for (int r = 0; r <= maxRing; r++)
+	{
+		const int z0 = std::max(c[2] - r, 0), z1 = std::min(c[2] + r, dims[2] - 1);
+		const int y0 = std::max(c[1] - r, 0), y1 = std::min(c[1] + r, dims[1] - 1);
+		const int x0 = std::max(c[0] - r, 0), x1 = std::min(c[0] + r, dims[0] - 1);
+		for (int z = z0; z <= z1; z++)
+		{
+			for (int y = y0; y <= y1; y++)
+			{
+				const bool innerYZ = std::abs(z - c[2]) < r && std::abs(y - c[1]) < r;
+				for (int x = x0; x <= x1; x++)
+				{
+					// only the shell of the ring, inner cells have been visited before
+					if (innerYZ && std::abs(x - c[0]) < r)
+					{
+						x = std::max(x, c[0] + r - 1);
+						continue;
+					}
+					size_t cell = (size_t(z) * dims[1] + y) * dims[0] + x;
+					for (size_t k = cellStart[cell]; k < cellStart[cell + 1]; k++)
+					{
+						size_t i = cellSamples[k];
+						float d = (samples[i] - q).sqlength();
+						if (d < bestDistance)
+						{
+							bestDistance = d;
+							best = i;
+						}
+					}
+				}
+			}
+		}
+		float bound = float(r) * cellSize;
+		if (bestDistance <= bound * bound) break;
+	}
+	return best;
+}
+
+// ========================
+// === SURFACE PROJECTOR ===
+// ========================
+
+SurfaceProjector::SurfaceProjector(const NURBS_Surface& surface_, const ProjectionSettings& settings_)
+	: surface(surface_)
+	, settings(settings_)
+	, index(surfaceSamples(surface_, settings_, sampleU, sampleV))
+{
+}
+
+float SurfaceProjector::projectPoint(const Vec3f& q, float& u, float& v, Vec3f& normal) const
+{
+	if (sampleU.empty())
+	{
+		// invalid surface
+		const float nan = std::numeric_limits<float>::quiet_NaN();
+		u = v = nan;
+		normal = Vec3f(nan, nan, nan);
+		return nan;
+	}
+	const unsigned int p = surface.degree;
+	const float minU = surface.knotVectorU[p];
+	const float maxU = surface.knotVectorU[surface.controlPoints[0].size()];
+	const float minV = surface.knotVectorV[p];
+	const float maxV = surface.knotVectorV[surface.controlPoints.size()];
+
+	size_t seed = index.nearest(q);
+	u = sampleU[seed];
+	v = sampleV[seed];
+
+	// damped Newton iteration on the gradient of the squared distance. a step is only accepted
+	// if it reduces the distance, otherwise the damping is increased (towards gradient descent).
+	// derivatives up to order 2: S[0] = S, S[1] = Sv, S[2] = Svv, S[3] = Su, S[4] = Suv, S[6] = Suu
+	Vec3f S[9];
+	surface.evaluateDerivatives(u, v, 2, S);
+	float distance = (S[0] - q).sqlength();
+	for (unsigned int iteration = 0; iteration < settings.maxIterations; iteration++)
+	{
+		Vec3f r = S[0] - q;
+		float f = S[3] * r;
+		float g = S[1] * r;
+		float J00 = S[3] * S[3] + r * S[6];
+		float J01 = S[3] * S[1] + r * S[4];
+		float J11 = S[1] * S[1] + r * S[2];
+		// parameters on the domain boundary with the descent direction pointing outside stay fixed
+		bool fixU = (u <= minU && f > 0.0f) || (u >= maxU && f < 0.0f);
+		bool fixV = (v <= minV && g > 0.0f) || (v >= maxV && g < 0.0f);
+		if (fixU && fixV) break;
+		float lambda = 0.0f;
+		bool accepted = false;
+		float step = 0.0f;
+		for (unsigned int attempt = 0; attempt < 8 && !accepted; attempt++)
+		{
+			float A00 = J00 + lambda;
+			float A11 = J11 + lambda;
+			float det = fixU ? A11 : (fixV ? A00 : A00 * A11 - J01 * J01);
+			if (det > 1e-20f && A00 > 0.0f && A11 > 0.0f)
+			{
+				float newU = u;
+				float newV = v;
+				if (fixU) newV = v - g / A11;
+				else if (fixV) newU = u - f / A00;
+				else
+				{
+					newU = u - (A11 * f - J01 * g) / det;
+					newV = v - (A00 * g - J01 * f) / det;
+				}
+				newU = std::min(std::max(newU, minU), maxU);
+				newV = std::min(std::max(newV, minV), maxV);
+				Vec3f trial[9];
+				surface.evaluateDerivatives(newU, newV, 2, trial);
+				float trialDistance = (trial[0] - q).sqlength();
+				if (trialDistance <= distance)
+				{
+					step = std::fabs(newU - u) + std::fabs(newV - v);
+					u = newU;
+					v = newV;
+					distance = trialDistance;
+					for (unsigned int i = 0; i < 9; i++) S[i] = trial[i];
+					accepted = true;
+				}
+			}
+			lambda = (lambda == 0.0f) ? 1e-3f * (std::fabs(J00) + std::fabs(J11)) + 1e-12f : lambda * 10.0f;
+		}
+		if (!accepted || step < settings.parameterTolerance) break;
+	}
+	normal = S[3] ^ S[1];
+	if (normal.sqlength() < 1e-12f)
+	{
+		// degenerate point (e.g. a pole): take the normal slightly inside the parameter domain
+		float insideU = u + (u < 0.5f * (minU + maxU) ? 1e-3f : -1e-3f) * (maxU - minU);
+		float insideV = v + (v < 0.5f * (minV + maxV) ? 1e-3f : -1e-3f) * (maxV - minV);
+		Vec3f Sn[4];
+		surface.evaluateDerivatives(insideU, insideV, 1, Sn);
+		normal = Sn[2] ^ Sn[1];
+	}
+	normal.normalize();
+	return (S[0] - q).length();
+}
+
+void SurfaceProjector::project(const std::vector<Vec3f>& queryPoints, const SurfaceProjectionBuffers& result) const
+{
+	parallelFor(queryPoints.size(), 256, [&](size_t begin, size_t end)
+	{
+		for (size_t i = begin; i < end; i++)
+		{
+			float u, v;
+			Vec3f normal;
+			float distance = projectPoint(queryPoints[i], u, v, normal);
+			if (result.u) result.u[i] = u;
+			if (result.v) result.v[i] = v;
+			if (result.distance) result.distance[i] = distance;
+			if (result.normalX) result.normalX[i] = normal.x;
+			if (result.normalY) result.normalY[i] = normal.y;
+			if (result.normalZ) result.normalZ[i] = normal.z;
+		}
+	});
+}
+
+// =======================
+// === CURVE PROJECTOR ===
+// =======================
+
+CurveProjector::CurveProjector(const NURBSCurve& curve_, const ProjectionSettings& settings_)
+	: curve(curve_)
+	, settings(settings_)
+	, index(curveSamples(curve_, settings_, sampleT))
+{
+}
+
+float CurveProjector::projectPoint(const Vec3f& q, float& t, Vec3f& normal) const
+{
+	if (sampleT.empty())
+	{
+		// invalid curve
+		const float nan = std::numeric_limits<float>::quiet_NaN();
+		t = nan;
+		normal = Vec3f(nan, nan, nan);
+		return nan;
+	}
+	const std::vector<float>& knotVector = curve.getKnotVector();
+	const float minT = knotVector[curve.getDegree()];
+	const float maxT = knotVector[curve.getControlPoints().size()];
+
+	t = sampleT[index.nearest(q)];
+
+	// damped Newton iteration on the derivative of the squared distance (see SurfaceProjector::projectPoint)
+	Vec3f C[3];
+	curve.evaluateDerivatives(t, 2, C);
+	float distance = (C[0] - q).sqlength();
+	for (unsigned int iteration = 0; iteration < settings.maxIterations; iteration++)
+	{
+		Vec3f r = C[0] - q;
+		float f = C[1] * r;
+		float df = C[1] * C[1] + C[2] * r;
+		float lambda = 0.0f;
+		bool accepted = false;
+		float step = 0.0f;
+		for (unsigned int attempt = 0; attempt < 8 && !accepted; attempt++)
+		{
+			if (df + lambda > 1e-20f && !((t <= minT && f > 0.0f) || (t >= maxT && f < 0.0f)))
+			{
+				float newT = std::min(std::max(t - f / (df + lambda), minT), maxT);
+				Vec3f trial[3];
+				curve.evaluateDerivatives(newT, 2, trial);
+				float trialDistance = (trial[0] - q).sqlength();
+				if (trialDistance <= distance)
+				{
+					step = std::fabs(newT - t);
+					t = newT;
+					distance = trialDistance;
+					for (unsigned int i = 0; i < 3; i++) C[i] = trial[i];
+					accepted = true;
+				}
+			}
+			lambda = (lambda == 0.0f) ? 1e-3f * std::fabs(df) + 1e-12f : lambda * 10.0f;
+		}
+		if (!accepted || step < settings.parameterTolerance) break;
+	}
+	normal = q - C[0];
+	distance = normal.length();
+	if (distance > 0.0f) normal /= distance;
+	return distance;
+}
+
+void CurveProjector::project(const std::vector<Vec3f>& queryPoints, const CurveProjectionBuffers& result) const
+{
+	parallelFor(queryPoints.size(), 256, [&](size_t begin, size_t end)
+	{
+		for (size_t i = begin; i < end; i++)
+		{
+			float t;
+			Vec3f normal;
+			float distance = projectPoint(queryPoints[i], t, normal);
+			if (result.t) result.t[i] = t;
+			if (result.distance) result.distance[i] = distance;
+			if (result.normalX) result.normalX[i] = normal.x;
+			if (result.normalY) result.normalY[i] = normal.y;
+			if (result.normalZ) result.normalZ[i] = normal.z;
+		}
+	});
+}
@@ -0,0 +1,131 @@
+#ifndef NURBS_PROJECTION_H
+#define NURBS_PROJECTION_H
+
+#include <stdlib.h>			// standard library
+#include <vector>			// std::vector<>
+
+#include "NURBS_Curve.h"
+#include "NURBS_Surface.h"
+#include "Vec3.h"
+
+// settings for the closest point projection
+struct ProjectionSettings
+{
+	unsigned int samplesPerSpan;	// seed samples per knot span (and direction)
+	unsigned int maxIterations;		// maximum number of Newton iterations per query point
+	float parameterTolerance;		// Newton iteration stops when the parameter step gets smaller
+
+	ProjectionSettings() : samplesPerSpan(8), maxIterations(12), parameterTolerance(1e-6f)
+	{
+	}
+};
+
+// caller-provided output buffers (structure of arrays) for surface projection.
+// every buffer which is not nullptr has to hold one entry per query point.
+struct SurfaceProjectionBuffers
+{
+	float* u;			// parameter u of the foot point
+	float* v;			// parameter v of the foot point
+	float* distance;	// euclidean distance between query point and foot point
+	float* normalX;		// unit surface normal (tangentU x tangentV) at the foot point
+	float* normalY;
+	float* normalZ;
+
+	SurfaceProjectionBuffers() : u(nullptr), v(nullptr), distance(nullptr), normalX(nullptr), normalY(nullptr), normalZ(nullptr)
+	{
+	}
+};
+
+// caller-provided output buffers (structure of arrays) for curve projection.
+// every buffer which is not nullptr has to hold one entry per query point.
+struct CurveProjectionBuffers
+{
+	float* t;			// parameter t of the foot point
+	float* distance;	// euclidean distance between query point and foot point
+	float* normalX;		// unit direction from the foot point to the query point (0 if the query point is on the curve)
+	float* normalY;
+	float* normalZ;
+
+	CurveProjectionBuffers() : t(nullptr), distance(nullptr), normalX(nullptr), normalY(nullptr), normalZ(nullptr)
+	{
+	}
+};
+
+// uniform grid over sample positions for nearest sample queries
+class SampleIndex
+{
+
+public:
+
+	// build the grid over the given sample positions
+	SampleIndex(const std::vector<Vec3f>& samples_);
+
+	// returns the index of the sample closest to q
+	size_t nearest(const Vec3f& q) const;
+
+private:
+
+	std::vector<Vec3f> samples;
+	std::vector<size_t> cellStart;		// first entry of each cell in cellSamples (one more entry than cells)
+	std::vector<size_t> cellSamples;	// sample indices sorted by cell
+	Vec3f minCorner;
+	Vec3f maxCorner;
+	float cellSize;
+	int dims[3];
+
+	// returns the cell coordinate of x along axis, clamped to the grid
+	int cellCoordinate(const float x, const int axis) const;
+
+};
+
+// closest point projection (point inversion) onto a NURBS surface.
+// seeds every query with the nearest of a set of tessellated samples and refines it with Newton iteration.
+// the projector works on its own copy of the surface, later changes of the surface are not seen. an invalid surface
+// gives NaN parameters, distances and normals. project() is thread-safe and runs multithreaded.
+class SurfaceProjector
+{
+
+public:
+
+	SurfaceProjector(const NURBS_Surface& surface_, const ProjectionSettings& settings_ = ProjectionSettings());
+
+	// project all query points onto the surface and write the results into the given buffers
+	void project(const std::vector<Vec3f>& queryPoints, const SurfaceProjectionBuffers& result) const;
+
+	// project a single point. returns the distance, u, v and the normal are written to the out-parameters.
+	float projectPoint(const Vec3f& q, float& u, float& v, Vec3f& normal) const;
+
+private:
+
+	const NURBS_Surface surface;
+	ProjectionSettings settings;
+	std::vector<float> sampleU;		// parameters of the seed samples
+	std::vector<float> sampleV;
+	SampleIndex index;
+
+};
+
+// closest point projection (point inversion) onto a NURBS curve. see SurfaceProjector.
+class CurveProjector
+{
+
+public:
+
+	CurveProjector(const NURBSCurve& curve_, const ProjectionSettings& settings_ = ProjectionSettings());
+
+	// project all query points onto the curve and write the results into the given buffers
+	void project(const std::vector<Vec3f>& queryPoints, const CurveProjectionBuffers& result) const;
+
+	// project a single point. returns the distance, t and the normal are written to the out-parameters.
+	float projectPoint(const Vec3f& q, float& t, Vec3f& normal) const;
+
+private:
+
+	const NURBSCurve curve;
+	ProjectionSettings settings;
+	std::vector<float> sampleT;		// parameters of the seed samples
+	SampleIndex index;
+
+};
+
+#endif // NURBS_PROJECTION_H
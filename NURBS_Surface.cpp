@@ -2,6 +2,16 @@
 
 #include <stdio.h>		// cout
 #include <iostream>		// cout
+#include <algorithm>	// std::min, std::sort
+#include <cmath>		// sqrt
+#include <numeric>		// std::iota
+#include <cassert>		// assert
+#include <atomic>		// std::atomic
+
+#include "NURBS_Basis.h"
+#include "NURBS_PowerBasis.h"
+#include "Parallel.h"
+#include "Profiler.h"
 
 NURBS_Surface::NURBS_Surface()
 {
@@ -40,7 +50,7 @@ NURBS_Surface::NURBS_Surface()
 
 	degree = 2;
 
-	isValidNURBS();
+	geometryChanged();
 }
 
 NURBS_Surface::NURBS_Surface(const std::vector<std::vector<Vec4f>>& controlPoints_, const std::vector<float>& knotVectorU_, const std::vector<float>& knotVectorV_, const unsigned int degree_)
@@ -49,94 +59,432 @@ NURBS_Surface::NURBS_Surface(const std::vector<std::vector<Vec4f>>& controlPoint
 	, knotVectorV(knotVectorV_)
 	, degree(degree_)
 {
-	isValidNURBS();
+	geometryChanged();
+}
+
+NURBS_Surface::NURBS_Surface(const NURBS_Surface& other)
+	: controlPoints(other.controlPoints)
+	, knotVectorU(other.knotVectorU)
+	, knotVectorV(other.knotVectorV)
+	, degree(other.degree)
+	, validationResult(other.validationResult)
+	, rational(other.rational)
+	, uniformSpansU(other.uniformSpansU)
+	, uniformSpansV(other.uniformSpansV)
+	, euclideanControlPoints(other.euclideanControlPoints)
+	, epoch(other.epoch)
+	, powerBasis(std::atomic_load(&other.powerBasis))
+{
+}
+
+NURBS_Surface& NURBS_Surface::operator=(const NURBS_Surface& other)
+{
+	controlPoints = other.controlPoints;
+	knotVectorU = other.knotVectorU;
+	knotVectorV = other.knotVectorV;
+	degree = other.degree;
+	validationResult = other.validationResult;
+	rational = other.rational;
+	uniformSpansU = other.uniformSpansU;
+	uniformSpansV = other.uniformSpansV;
+	euclideanControlPoints = other.euclideanControlPoints;
+	epoch = other.epoch;
+	std::atomic_store(&powerBasis, std::atomic_load(&other.powerBasis));
+	return *this;
+}
+
+bool NURBS_Surface::isValidNURBS() const
+{
+#ifdef NURBS_DEBUG_VALIDATION
+	// stale data means the surface was changed without geometryChanged(). the kernels would read an outdated classification
+	// and Euclidean control mesh.
+	const NURBS_Surface current(controlPoints, knotVectorU, knotVectorV, degree);
+	assert(validationResult == current.validationResult);
+	assert(rational == current.rational);
+	assert(uniformSpansU == current.uniformSpansU && uniformSpansV == current.uniformSpansV);
+	assert(euclideanControlPoints == current.euclideanControlPoints);
+#endif
+	return validationResult.isValid();
 }
 
-bool NURBS_Surface::isValidNURBS()
+// source of NURBS_Surface::geometryEpoch, shared by all surfaces
+static std::atomic<unsigned long long> nextGeometryEpoch(1);
+
+void NURBS_Surface::geometryChanged()
 {
-	// knot vector U verification
-	bool validU = true;
-	for (unsigned int i = 1; i < knotVectorU.size() && validU == true; ++i)
+	epoch = nextGeometryEpoch++;
+	validationResult = validateSurface(controlPoints, knotVectorU, knotVectorV, degree);
+	uniformSpansU = UniformKnotSpans();
+	uniformSpansV = UniformKnotSpans();
+	if (validationResult.isValid())
+	{
+		uniformSpansU = findUniformKnotSpans(knotVectorU, degree, controlPoints[0].size());
+		uniformSpansV = findUniformKnotSpans(knotVectorV, degree, controlPoints.size());
+	}
+	rational = false;
+	for (const std::vector<Vec4f>& row : controlPoints)
+		for (const Vec4f& point : row) rational = rational || point.w != 1.0f;
+	// the polynomial kernels read 3 instead of 4 floats per control point
+	euclideanControlPoints.clear();
+	if (!rational && validationResult.isValid())
 	{
-		if (knotVectorU[i] < knotVectorU[i-1])
+		euclideanControlPoints.reserve(controlPoints.size() * controlPoints[0].size());
+		for (const std::vector<Vec4f>& row : controlPoints)
+			for (const Vec4f& point : row) euclideanControlPoints.push_back(Vec3f(point.x, point.y, point.z));
+	}
+	std::atomic_store(&powerBasis, std::shared_ptr<const SurfacePowerBasis>());
+}
+
+Vec4f NURBS_Surface::evaluteDeBoor(const float u, const float v, Vec4f& tangentU, Vec4f& tangentV) const
+{
+	if(!isValidNURBS())
+		return Vec4f();
+	// TODO: evaluate the surface by evaluating curves
+	// ===============================================
+	// evaluate the patch at u in all rows, then the resulting curve at v
+	extractIsoCurveU(u).evaluteDeBoor(v, tangentV);
+	// evaluate the patch at v in all columns, then the resulting curve at u
+	Vec4f evaluatedPoint = extractIsoCurveV(v).evaluteDeBoor(u, tangentU);
+	// ===============================================
+	return evaluatedPoint;
+}
+
+void NURBS_Surface::evaluateDerivatives(const float u, const float v, const unsigned int order, Vec3f* derivatives) const
+{
+	const unsigned int p = degree;
+	const unsigned int n = order + 1;
+	// the basis function and weight tables hold NURBS_MAX_DEGREE + 1 orders
+	if (!isValidNURBS() || order > NURBS_MAX_DEGREE)
+	{
+		for (unsigned int k = 0; k < n * n; k++) derivatives[k] = Vec3f();
+		return;
+	}
+	float Nu[(NURBS_MAX_DEGREE + 1) * (NURBS_MAX_DEGREE + 1)];
+	float Nv[(NURBS_MAX_DEGREE + 1) * (NURBS_MAX_DEGREE + 1)];
+	int spanU = findSpan(knotVectorU, p, controlPoints[0].size(), u);
+	int spanV = findSpan(knotVectorV, p, controlPoints.size(), v);
+	basisFunctionDerivatives(knotVectorU, uniformSpansU, p, spanU, u, order, Nu);
+	basisFunctionDerivatives(knotVectorV, uniformSpansV, p, spanV, v, order, Nv);
+	// partial derivatives of the homogeneous surface d^(k+l) A / du^k dv^l: xyz go to derivatives[k * n + l], w to weights[k * n + l].
+	// the control rows are blended in u direction first: temp[j] = sum_i Nu^(k)_i * P[j][i]
+	float weights[(NURBS_MAX_DEGREE + 1) * (NURBS_MAX_DEGREE + 1)];
+	Vec4f temp[NURBS_MAX_DEGREE + 1];
+	for (unsigned int k = 0; k <= order; k++)
+	{
+		if (k <= p)
+		{
+			for (unsigned int j = 0; j <= p; j++)
+			{
+				const std::vector<Vec4f>& row = controlPoints[spanV - p + j];
+				Vec4f sum;
+				for (unsigned int i = 0; i <= p; i++) sum += row[spanU - p + i] * Nu[k * (p + 1) + i];
+				temp[j] = sum;
+			}
+		}
+		for (unsigned int l = 0; l <= order; l++)
 		{
-			std::cout << "INVALID (unsorted) knotVectorU.\n";
-			validU = false;
-			break;
+			Vec4f A;
+			if (k <= p && k + l <= order)
+				for (unsigned int j = 0; j <= p; j++) A += temp[j] * Nv[l * (p + 1) + j];
+			derivatives[k * n + l] = Vec3f(A.x, A.y, A.z);
+			weights[k * n + l] = A.w;
 		}
 	}
-	// knot vector V verification
-	bool validV = true;
-	for (unsigned int i = 1; i < knotVectorV.size() && validV == true; ++i)
+	// a polynomial surface is its homogeneous surface
+	if (!rational) return;
+	// partial derivatives of the rational surface, in place (algorithm A4.4 from Piegl/Tiller "The NURBS Book")
+	for (unsigned int k = 0; k <= order; k++)
 	{
-		if (knotVectorV[i] < knotVectorV[i-1])
+		for (unsigned int l = 0; k + l <= order; l++)
 		{
-			std::cout << "INVALID (unsorted) knotVectorV.\n";
-			validV = false;
-			break;
+			Vec3f d = derivatives[k * n + l];
+			for (unsigned int j = 1; j <= l; j++) d -= derivatives[k * n + l - j] * (binomial(l, j) * weights[j]);
+			for (unsigned int i = 1; i <= k; i++)
+			{
+				d -= derivatives[(k - i) * n + l] * (binomial(k, i) * weights[i * n]);
+				Vec3f d2;
+				for (unsigned int j = 1; j <= l; j++) d2 += derivatives[(k - i) * n + l - j] * (binomial(l, j) * weights[i * n + j]);
+				d -= d2 * binomial(k, i);
+			}
+			derivatives[k * n + l] = d / weights[0];
 		}
 	}
-	// size verification
-	bool validSize = true;
-	for (unsigned int i = 1; i < controlPoints.size() && validSize == true; ++i)
+}
+
+void NURBS_Surface::evaluateDerivatives(const float u, const float v, const unsigned int order, std::vector<Vec3f>& derivatives) const
+{
+	derivatives.resize((order + 1) * (order + 1));
+	evaluateDerivatives(u, v, order, derivatives.data());
+}
+
+// queries processed per task of the batched evaluation
+static const size_t BATCH_GRAIN = 1024;
+
+// spans of the parameters and the order of the parameters sorted by span (ascending input keeps its order)
+static void sortBySpan(const std::vector<float>& knotVector, const unsigned int p, const size_t numControlPoints, const std::vector<float>& parameters,
+	std::vector<int>& spans, std::vector<size_t>& order)
+{
+	spans.resize(parameters.size());
+	for (size_t i = 0; i < parameters.size(); i++) spans[i] = findSpan(knotVector, p, numControlPoints, parameters[i]);
+	order.resize(parameters.size());
+	std::iota(order.begin(), order.end(), size_t(0));
+	if (!std::is_sorted(spans.begin(), spans.end()))
+		std::stable_sort(order.begin(), order.end(), [&spans](const size_t a, const size_t b) { return spans[a] < spans[b]; });
+}
+
+// basis functions and their first derivatives at all parameters, 2 * (p + 1) values per parameter
+static std::vector<float> firstOrderBasis(const std::vector<float>& knotVector, const UniformKnotSpans& uniform, const unsigned int p, const std::vector<int>& spans, const std::vector<float>& parameters)
+{
+	std::vector<float> basis(parameters.size() * 2 * (p + 1));
+	for (size_t i = 0; i < parameters.size(); i++) basisFunctionDerivatives(knotVector, uniform, p, spans[i], parameters[i], 1, &basis[i * 2 * (p + 1)]);
+	return basis;
+}
+
+// the unit normal Su x Sv, zero where the surface is degenerate
+static Vec3f unitNormal(const Vec3f& Su, const Vec3f& Sv)
+{
+	const Vec3f normal = Su ^ Sv;
+	const float squaredLength = normal.sqlength();
+	return squaredLength > 1e-20f ? normal / std::sqrt(squaredLength) : Vec3f();
+}
+
+// point and partial derivatives of a polynomial surface, stored at index n of buffers
+static void storeFirstOrder(const Vec3f& S, const Vec3f& Su, const Vec3f& Sv, const size_t n, const SurfaceSampleBuffers& buffers)
+{
+	if (buffers.points) buffers.points[n] = S;
+	if (buffers.tangentsU) buffers.tangentsU[n] = Su;
+	if (buffers.tangentsV) buffers.tangentsV[n] = Sv;
+	if (buffers.normals) buffers.normals[n] = unitNormal(Su, Sv);
+}
+
+// the rational point and partial derivatives from the homogeneous ones A, dA/du and dA/dv, stored at index n of buffers
+static void storeFirstOrder(const Vec4f& A, const Vec4f& Au, const Vec4f& Av, const size_t n, const SurfaceSampleBuffers& buffers)
+{
+	const float inverseWeight = 1.0f / A.w;
+	const Vec3f S(A.x * inverseWeight, A.y * inverseWeight, A.z * inverseWeight);
+	const Vec3f Su((Au.x - Au.w * S.x) * inverseWeight, (Au.y - Au.w * S.y) * inverseWeight, (Au.z - Au.w * S.z) * inverseWeight);
+	const Vec3f Sv((Av.x - Av.w * S.x) * inverseWeight, (Av.y - Av.w * S.y) * inverseWeight, (Av.z - Av.w * S.z) * inverseWeight);
+	storeFirstOrder(S, Su, Sv, n, buffers);
+}
+
+// control mesh as seen by the batch kernels: homogeneous rows of a rational surface
+struct HomogeneousNet
+{
+	typedef Vec4f Point;
+	const std::vector<std::vector<Vec4f>>& controlPoints;
+	const Vec4f* row(const size_t r) const { return controlPoints[r].data(); }
+};
+
+// x, y, z of the rows of a polynomial surface
+struct EuclideanNet
+{
+	typedef Vec3f Point;
+	const Vec3f* points;
+	size_t numColumns;
+	const Vec3f* row(const size_t r) const { return points + r * numColumns; }
+};
+
+template<class Net>
+static void evaluateListKernel(const Net& net, const std::vector<float>& knotVectorU, const std::vector<float>& knotVectorV, const UniformKnotSpans& uniformU, const UniformKnotSpans& uniformV, const unsigned int p,
+	const std::vector<float>& U, const std::vector<float>& V, const std::vector<int>& spansU, const std::vector<int>& spansV, const std::vector<size_t>& order,
+	const SurfaceSampleBuffers& buffers)
+{
+	typedef typename Net::Point Point;
+	parallelFor(order.size(), BATCH_GRAIN, [&](size_t begin, size_t end)
 	{
-		if (controlPoints[i].size() != controlPoints[i-1].size())
+		float Nu[2 * (NURBS_MAX_DEGREE + 1)];
+		float Nv[2 * (NURBS_MAX_DEGREE + 1)];
+		for (size_t m = begin; m < end; m++)
 		{
-			std::cout << "INVALID mesh (Each row has to have the same number of control points).\n";
-			validSize = false;
+			const size_t n = order[m];
+			const int spanU = spansU[n];
+			const int spanV = spansV[n];
+			basisFunctionDerivatives(knotVectorU, uniformU, p, spanU, U[n], 1, Nu);
+			basisFunctionDerivatives(knotVectorV, uniformV, p, spanV, V[n], 1, Nv);
+			Point A, Au, Av;
+			for (unsigned int j = 0; j <= p; j++)
+			{
+				// blend the control row in u direction, then the rows in v direction
+				const Point* row = net.row(spanV - p + j) + (spanU - p);
+				Point R, Ru;
+				for (unsigned int i = 0; i <= p; i++)
+				{
+					R += row[i] * Nu[i];
+					Ru += row[i] * Nu[p + 1 + i];
+				}
+				A += R * Nv[j];
+				Au += Ru * Nv[j];
+				Av += R * Nv[p + 1 + j];
+			}
+			storeFirstOrder(A, Au, Av, n, buffers);
 		}
-	}
-	if (controlPoints[0].size() + degree + 1 != knotVectorU.size()) 
+	});
+}
+
+template<class Net>
+static void evaluateGridKernel(const Net& net, const size_t numRows, const unsigned int p, const std::vector<int>& spansU, const std::vector<int>& spansV,
+	const std::vector<size_t>& orderU, const std::vector<size_t>& orderV, const std::vector<float>& basisU, const std::vector<float>& basisV,
+	const SurfaceSampleBuffers& buffers)
+{
+	typedef typename Net::Point Point;
+	const size_t numPointsV = orderV.size();
+	// whole grid rows per task, at least BATCH_GRAIN samples
+	parallelFor(orderU.size(), std::max(BATCH_GRAIN / std::max(numPointsV, size_t(1)), size_t(1)), [&](size_t begin, size_t end)
 	{
-		std::cout << "INVALID size in u direction (controlPoints[0].size() + degree + 1 != knotVectorU.size()).\n";
-		validSize = false;
-	}
-	if (controlPoints.size() + degree + 1 != knotVectorV.size()) 
+		// every control row blended in u direction at U[i]: R = sum Nu * P, Ru = sum Nu' * P
+		std::vector<Point> R(numRows);
+		std::vector<Point> Ru(numRows);
+		for (size_t m = begin; m < end; m++)
+		{
+			const size_t i = orderU[m];
+			const float* Nu = &basisU[i * 2 * (p + 1)];
+			const int spanU = spansU[i];
+			for (size_t r = 0; r < numRows; r++)
+			{
+				const Point* row = net.row(r) + (spanU - p);
+				Point sum, sumU;
+				for (unsigned int k = 0; k <= p; k++)
+				{
+					sum += row[k] * Nu[k];
+					sumU += row[k] * Nu[p + 1 + k];
+				}
+				R[r] = sum;
+				Ru[r] = sumU;
+			}
+			// the iso curve at U[i] in v direction
+			for (size_t jj = 0; jj < numPointsV; jj++)
+			{
+				const size_t j = orderV[jj];
+				const float* Nv = &basisV[j * 2 * (p + 1)];
+				const size_t first = spansV[j] - p;
+				Point A, Au, Av;
+				for (unsigned int k = 0; k <= p; k++)
+				{
+					A += R[first + k] * Nv[k];
+					Au += Ru[first + k] * Nv[k];
+					Av += R[first + k] * Nv[p + 1 + k];
+				}
+				storeFirstOrder(A, Au, Av, i * numPointsV + j, buffers);
+			}
+		}
+	});
+}
+
+bool NURBS_Surface::evaluateSurfaceAt(const std::vector<float>& U, const std::vector<float>& V, const SurfaceSampleBuffers& buffers) const
+{
+	PROFILE_SCOPE("NURBS_Surface::evaluateSurfaceAt");
+	if (!isValidNURBS()) return false;
+	const unsigned int p = degree;
+	const size_t numColumns = controlPoints[0].size();
+	const size_t count = std::min(U.size(), V.size());
+	// sort the queries by span (v major), so consecutive queries blend the same control points
+	std::vector<int> spansU(count);
+	std::vector<int> spansV(count);
+	std::vector<size_t> keys(count);
+	for (size_t n = 0; n < count; n++)
 	{
-		std::cout << "INVALID size in v direction (controlPoints.size() + degree + 1 != knotVectorV.size()).\n";
-		validSize = false;
+		spansU[n] = findSpan(knotVectorU, p, numColumns, U[n]);
+		spansV[n] = findSpan(knotVectorV, p, controlPoints.size(), V[n]);
+		keys[n] = size_t(spansV[n]) * numColumns + size_t(spansU[n]);
 	}
-	return (validU && validV && validSize);
+	std::vector<size_t> order(count);
+	std::iota(order.begin(), order.end(), size_t(0));
+	if (!std::is_sorted(keys.begin(), keys.end()))
+		std::stable_sort(order.begin(), order.end(), [&keys](const size_t a, const size_t b) { return keys[a] < keys[b]; });
+
+	if (rational) evaluateListKernel(HomogeneousNet{ controlPoints }, knotVectorU, knotVectorV, uniformSpansU, uniformSpansV, p, U, V, spansU, spansV, order, buffers);
+	else evaluateListKernel(EuclideanNet{ euclideanControlPoints.data(), numColumns }, knotVectorU, knotVectorV, uniformSpansU, uniformSpansV, p, U, V, spansU, spansV, order, buffers);
+	return true;
 }
 
-Vec4f NURBS_Surface::evaluteDeBoor(const float u, const float v, Vec4f& tangentU, Vec4f& tangentV)
+bool NURBS_Surface::evaluateSurfaceAtGrid(const std::vector<float>& U, const std::vector<float>& V, const SurfaceSampleBuffers& buffers) const
 {
-	Vec4f evaluatedPoint;
-	if(!isValidNURBS())
-		return Vec4f();
-	// TODO: evaluate the surface by evaluating curves
-	// ===============================================
-	const size_t size_u = controlPoints.size();
-	const size_t size_v = controlPoints.at(0).size();
+	PROFILE_SCOPE("NURBS_Surface::evaluateSurfaceAtGrid");
+	if (!isValidNURBS()) return false;
+	const unsigned int p = degree;
+	const size_t numRows = controlPoints.size();
+	std::vector<int> spansU, spansV;
+	std::vector<size_t> orderU, orderV;
+	sortBySpan(knotVectorU, p, controlPoints[0].size(), U, spansU, orderU);
+	sortBySpan(knotVectorV, p, numRows, V, spansV, orderV);
+	const std::vector<float> basisU = firstOrderBasis(knotVectorU, uniformSpansU, p, spansU, U);
+	const std::vector<float> basisV = firstOrderBasis(knotVectorV, uniformSpansV, p, spansV, V);
+
+	if (rational) evaluateGridKernel(HomogeneousNet{ controlPoints }, numRows, p, spansU, spansV, orderU, orderV, basisU, basisV, buffers);
+	else evaluateGridKernel(EuclideanNet{ euclideanControlPoints.data(), controlPoints[0].size() }, numRows, p, spansU, spansV, orderU, orderV, basisU, basisV, buffers);
+	return true;
+}
+
+NURBSCurve NURBS_Surface::extractIsoCurveU(const float u) const
+{
+	if (!isValidNURBS()) return NURBSCurve(std::vector<Vec4f>(), knotVectorV, degree);
+	const unsigned int p = degree;
+	float Nu[NURBS_MAX_DEGREE + 1];
+	const int span = findSpan(knotVectorU, p, controlPoints[0].size(), u);
+	basisFunctionDerivatives(knotVectorU, uniformSpansU, p, span, u, 0, Nu);
+	// blend the homogeneous control points of every row, this is exact for the rational surface
+	std::vector<Vec4f> points(controlPoints.size());
+	for (size_t r = 0; r < controlPoints.size(); r++)
+		for (unsigned int k = 0; k <= p; k++) points[r] += controlPoints[r][span - p + k] * Nu[k];
+	// the basis functions sum up to 1 only up to rounding, a polynomial iso curve keeps its weights exactly 1
+	if (!rational) for (Vec4f& point : points) point.w = 1.0f;
+	return NURBSCurve(points, knotVectorV, p);
+}
 
-	// evaluate the patch at u in all rows
-	std::vector<Vec4f> points_u;
-	for (size_t i = 0; i < size_u; i++)
+NURBSCurve NURBS_Surface::extractIsoCurveV(const float v) const
+{
+	if (!isValidNURBS()) return NURBSCurve(std::vector<Vec4f>(), knotVectorU, degree);
+	const unsigned int p = degree;
+	float Nv[NURBS_MAX_DEGREE + 1];
+	const int span = findSpan(knotVectorV, p, controlPoints.size(), v);
+	basisFunctionDerivatives(knotVectorV, uniformSpansV, p, span, v, 0, Nv);
+	std::vector<Vec4f> points(controlPoints[0].size());
+	for (unsigned int k = 0; k <= p; k++)
 	{
-		points_u.push_back(NURBSCurve(controlPoints.at(i), knotVectorU, degree).evaluteDeBoor(u, Vec4f()));
+		const std::vector<Vec4f>& row = controlPoints[span - p + k];
+		for (size_t c = 0; c < points.size(); c++) points[c] += row[c] * Nv[k];
 	}
-	// evaluate curve-at-u at v
-	evaluatedPoint = NURBSCurve(points_u, knotVectorV, degree).evaluteDeBoor(v, tangentV);
+	// the basis functions sum up to 1 only up to rounding, a polynomial iso curve keeps its weights exactly 1
+	if (!rational) for (Vec4f& point : points) point.w = 1.0f;
+	return NURBSCurve(points, knotVectorU, p);
+}
 
+std::shared_ptr<const SurfacePowerBasis> NURBS_Surface::getPowerBasis() const
+{
+	std::shared_ptr<const SurfacePowerBasis> current = std::atomic_load(&powerBasis);
+	if (current) return current;
+	// threads racing here build equal forms, the last one stored wins
+	current = std::make_shared<SurfacePowerBasis>(*this);
+	std::atomic_store(&powerBasis, current);
+	return current;
+}
 
-	// evaluate the patch at v in all columns
-	std::vector<Vec4f> points_v;
-	for (size_t i = 0; i < size_v; i++)
+NURBSCurve NURBS_Surface::controlColumnCurve(const size_t i) const
+{
+	std::vector<Vec4f> points;
+	points.reserve(controlPoints.size());
+	for (const std::vector<Vec4f>& row : controlPoints) points.push_back(row.at(i));
+	return NURBSCurve(points, knotVectorV, degree);
+}
+
+NURBSCurve NURBS_Surface::controlRowCurve(const size_t j) const
+{
+	return NURBSCurve(controlPoints.at(j), knotVectorU, degree);
+}
+
+std::vector<Vec3f> NURBS_Surface::evaluateDerivativesAt(const std::vector<float>& U, const std::vector<float>& V, const unsigned int order) const
+{
+	const size_t count = std::min(U.size(), V.size());
+	const size_t stride = (order + 1) * (order + 1);
+	std::vector<Vec3f> derivatives(count * stride);
+	parallelFor(count, 256, [&](size_t begin, size_t end)
 	{
-		std::vector<Vec4f> nurbs_points;
-		for (size_t j = 0; j < size_u; j++)
-		{
-			nurbs_points.push_back(controlPoints.at(j).at(i));
-		}
-		points_v.push_back(NURBSCurve(nurbs_points, knotVectorV, degree).evaluteDeBoor(v, Vec4f()));
-	}
-	// evaluate curve-at-v at u
-	evaluatedPoint = NURBSCurve(points_v, knotVectorU, degree).evaluteDeBoor(u, tangentU);
-	// ===============================================
-	return evaluatedPoint;
+		for (size_t i = begin; i < end; i++) evaluateDerivatives(U[i], V[i], order, &derivatives[i * stride]);
+	});
+	return derivatives;
 }
 
-std::ostream& operator<< (std::ostream& os, NURBS_Surface& nurbsSurface)
+std::ostream& operator<< (std::ostream& os, const NURBS_Surface& nurbsSurface)
 {
 	// degree
 	os << "NURBS surface, degree " << nurbsSurface.degree << "\n";
@@ -158,6 +506,6 @@ std::ostream& operator<< (std::ostream& os, NURBS_Surface& nurbsSurface)
 	for (unsigned int i = 0; i < nurbsSurface.knotVectorV.size(); ++i) os << nurbsSurface.knotVectorV[i] << ", ";
 	os << "\n";
 	// knot vector verification
-	nurbsSurface.isValidNURBS();
+	os << "  " << nurbsSurface.validation() << "\n";
 	return os;
 }
\ No newline at end of file
@@ -2,11 +2,31 @@
 #define NURBS_SURFACE_H
 
 #include <stdlib.h>			// standard library
+#include <memory>			// std::shared_ptr<>
 #include <vector>			// std::vector<>
 
 #include "NURBS_Curve.h"
+#include "NURBS_Validation.h"
+#include "Vec3.h"
 #include "Vec4.h"
 
+// caller-provided output of the batched surface evaluation, one array per attribute. every array which is not nullptr
+// receives one entry per query, attributes which are not needed are skipped.
+struct SurfaceSampleBuffers
+{
+	Vec3f* points;		// homogenized surface points S
+	Vec3f* tangentsU;	// partial derivatives dS/du
+	Vec3f* tangentsV;	// partial derivatives dS/dv
+	Vec3f* normals;		// unit normals dS/du x dS/dv (zero where the surface is degenerate)
+
+	SurfaceSampleBuffers(Vec3f* points_ = nullptr, Vec3f* tangentsU_ = nullptr, Vec3f* tangentsV_ = nullptr, Vec3f* normals_ = nullptr)
+		: points(points_), tangentsU(tangentsU_), tangentsV(tangentsV_), normals(normals_)
+	{
+	}
+};
+
+class SurfacePowerBasis;	// NURBS_PowerBasis.h
+
 class NURBS_Surface {
 
 public:
@@ -23,15 +43,84 @@ public:
 	// constructor which takes given control mesh P, knot vector U and V and degree p
 	NURBS_Surface(const std::vector<std::vector<Vec4f>>& controlPoints_, const std::vector<float>& knotVectorU_, const std::vector<float>& knotVectorV_, const unsigned int degree_);
 
-	// returns false if the knot vector is not sorted or if the dimensions of knot vector, control points and p do not match
-	bool isValidNURBS();
+	// copies share the power basis, which is read with std::atomic_load because other threads may be building it
+	NURBS_Surface(const NURBS_Surface& other);
+	NURBS_Surface& operator=(const NURBS_Surface& other);
+	NURBS_Surface(NURBS_Surface&& other) = default;
+	NURBS_Surface& operator=(NURBS_Surface&& other) = default;
+
+	// returns false if the knot vector is not sorted or if the dimensions of knot vector, control points and p do not match.
+	// the result is cached by the constructors and geometryChanged().
+	bool isValidNURBS() const;
+
+	// returns the cached validation result
+	const NURBSValidation& validation() const { return validationResult; }
+
+	// revalidates and reclassifies the surface (rational or not, uniform knot spans). has to be called after control points,
+	// knot vectors or degree were modified.
+	void geometryChanged();
+
+	// false if all weights are 1 (set by geometryChanged). the evaluation of such polynomial surfaces skips the weights and the division by w.
+	bool isRational() const { return rational; }
+
+	// identifies the current geometry: a new value for every geometryChanged() of any surface, copies keep it. caches of
+	// data derived from a surface can be keyed on it instead of on the surface address.
+	unsigned long long geometryEpoch() const { return epoch; }
 
 	// evaluate the curve at parameter t with deBoor (inserting a knot until its multiplicity is p). also returns the tangent at the evaluated point.
-	Vec4f evaluteDeBoor(const float u, const float v, Vec4f& tangentU, Vec4f& tangentV);
+	// like all const members it only reads the surface, so any number of threads may evaluate one surface at once.
+	Vec4f evaluteDeBoor(const float u, const float v, Vec4f& tangentU, Vec4f& tangentV) const;
+
+	// evaluate the homogenized surface and all partial derivatives up to total order (<= NURBS_MAX_DEGREE) at (u, v) in one pass.
+	// derivatives has to hold (order + 1)^2 entries, derivatives[k * (order + 1) + l] is d^(k+l) S / du^k dv^l for k + l <= order.
+	// all entries are zero if the surface is invalid or order > NURBS_MAX_DEGREE.
+	void evaluateDerivatives(const float u, const float v, const unsigned int order, Vec3f* derivatives) const;
+
+	// same as above, resizes derivatives to (order + 1)^2 entries
+	void evaluateDerivatives(const float u, const float v, const unsigned int order, std::vector<Vec3f>& derivatives) const;
+
+	// evaluate the derivatives up to order at all parameter pairs (U[i], V[i]). returns (order + 1)^2 entries per pair, ordered like U and V.
+	std::vector<Vec3f> evaluateDerivativesAt(const std::vector<float>& U, const std::vector<float>& V, const unsigned int order) const;
+
+	// evaluate points, partial derivatives and normals at all parameter pairs (U[i], V[i]) into buffers (entry i each).
+	// the queries are processed sorted by knot span and in parallel for large batches. returns false if the surface is not valid.
+	bool evaluateSurfaceAt(const std::vector<float>& U, const std::vector<float>& V, const SurfaceSampleBuffers& buffers) const;
+
+	// same for the rectilinear grid U x V, entry i * V.size() + j holds (U[i], V[j]) like TessellatedMesh.
+	// the basis functions are computed once per parameter and the control rows are blended once per U[i].
+	bool evaluateSurfaceAtGrid(const std::vector<float>& U, const std::vector<float>& V, const SurfaceSampleBuffers& buffers) const;
+
+	// returns the exact iso curve C(v) = S(u, v) at fixed u (knot vector V). its control points are the control columns
+	// blended with the basis functions at u. a curve without control points is returned if the surface is not valid.
+	NURBSCurve extractIsoCurveU(const float u) const;
+
+	// returns the exact iso curve C(u) = S(u, v) at fixed v (knot vector U), see extractIsoCurveU
+	NURBSCurve extractIsoCurveV(const float v) const;
+
+	// returns the curve through the control points of column i (in v direction, knot vector V)
+	NURBSCurve controlColumnCurve(const size_t i) const;
+
+	// returns the curve through the control points of row j (in u direction, knot vector U)
+	NURBSCurve controlRowCurve(const size_t j) const;
+
+	// returns the power basis form of the surface for fast repeated evaluation (see NURBS_PowerBasis.h). it is built on
+	// first use and shared by all threads until geometryChanged(). an invalid surface gives an empty form.
+	std::shared_ptr<const SurfacePowerBasis> getPowerBasis() const;
+
+private:
+
+	// validation and classification of the class data, see geometryChanged()
+	NURBSValidation validationResult;
+	bool rational;
+	UniformKnotSpans uniformSpansU;		// spans of (clamped) uniform knot vectors, their basis functions come from the uniform basis matrix
+	UniformKnotSpans uniformSpansV;
+	std::vector<Vec3f> euclideanControlPoints;		// x, y, z of the control mesh row after row, only for polynomial surfaces
+	unsigned long long epoch;		// see geometryEpoch()
+	mutable std::shared_ptr<const SurfacePowerBasis> powerBasis;	// built by getPowerBasis(), only accessed through std::atomic_load / std::atomic_store
 
 };
 
 // ostream << operator. E.g. use "std::cout << nurbs << std::endl;"
-std::ostream& operator<< (std::ostream& os, NURBS_Surface& nurbsSurface);
+std::ostream& operator<< (std::ostream& os, const NURBS_Surface& nurbsSurface);
 
 #endif
\ No newline at end of file
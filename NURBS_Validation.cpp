@@ -0,0 +1,61 @@
+#include "NURBS_Validation.h"
+
+#include <iostream>		// std::ostream
+
+#include "NURBS_Basis.h"
+
+// knots of one direction: sorted and as many as control points + degree + 1
+static NURBSValidation validateKnots(const std::vector<float>& knotVector, const size_t numControlPoints, const unsigned int degree, const char direction)
+{
+	for (size_t i = 1; i < knotVector.size(); i++)
+		if (knotVector[i] < knotVector[i - 1]) return NURBSValidation(NURBS_UNSORTED_KNOTS, direction, i - 1);
+	if (numControlPoints + degree + 1 != knotVector.size()) return NURBSValidation(NURBS_KNOT_COUNT_MISMATCH, direction);
+	if (numControlPoints <= degree) return NURBSValidation(NURBS_TOO_FEW_CONTROL_POINTS, direction);
+	return NURBSValidation();
+}
+
+NURBSValidation validateKnotVector(const std::vector<float>& knotVector, const size_t numControlPoints, const unsigned int degree)
+{
+	if (degree > NURBS_MAX_DEGREE) return NURBSValidation(NURBS_DEGREE_NOT_SUPPORTED);
+	return validateKnots(knotVector, numControlPoints, degree, 0);
+}
+
+NURBSValidation validateCurve(const std::vector<Vec4f>& controlPoints, const std::vector<float>& knotVector, const unsigned int degree)
+{
+	return validateKnotVector(knotVector, controlPoints.size(), degree);
+}
+
+NURBSValidation validateSurface(const std::vector<std::vector<Vec4f>>& controlPoints, const std::vector<float>& knotVectorU, const std::vector<float>& knotVectorV, const unsigned int degree)
+{
+	if (degree > NURBS_MAX_DEGREE) return NURBSValidation(NURBS_DEGREE_NOT_SUPPORTED);
+	if (controlPoints.empty()) return NURBSValidation(NURBS_TOO_FEW_CONTROL_POINTS, 'v');
+	for (size_t i = 1; i < controlPoints.size(); i++)
+		if (controlPoints[i].size() != controlPoints[0].size()) return NURBSValidation(NURBS_IRREGULAR_CONTROL_NET, 'v', i);
+	NURBSValidation validation = validateKnots(knotVectorU, controlPoints[0].size(), degree, 'u');
+	if (!validation.isValid()) return validation;
+	return validateKnots(knotVectorV, controlPoints.size(), degree, 'v');
+}
+
+const char* validationErrorName(const NURBSValidationError error)
+{
+	switch (error)
+	{
+	case NURBS_VALID: return "valid";
+	case NURBS_UNSORTED_KNOTS: return "unsorted knot vector";
+	case NURBS_KNOT_COUNT_MISMATCH: return "control points + degree + 1 != knots";
+	case NURBS_IRREGULAR_CONTROL_NET: return "control rows of different size";
+	case NURBS_TOO_FEW_CONTROL_POINTS: return "less than degree + 1 control points";
+	case NURBS_DEGREE_NOT_SUPPORTED: return "degree not supported";
+	default: return "unknown";
+	}
+}
+
+std::ostream& operator<< (std::ostream& os, const NURBSValidation& validation)
+{
+	if (validation.isValid()) return os << "valid";
+	os << "INVALID (" << validationErrorName(validation.error);
+	if (validation.direction) os << ", " << validation.direction << " direction";
+	if (validation.error == NURBS_UNSORTED_KNOTS) os << ", knot " << validation.index;
+	if (validation.error == NURBS_IRREGULAR_CONTROL_NET) os << ", row " << validation.index;
+	return os << ")";
+}
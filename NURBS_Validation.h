@@ -0,0 +1,57 @@
+#ifndef NURBS_VALIDATION_H
+#define NURBS_VALIDATION_H
+
+#include <stdlib.h>			// standard library
+#include <iosfwd>			// std::ostream
+#include <vector>			// std::vector<>
+
+#include "Vec4.h"
+
+// define NURBS_DEBUG_VALIDATION (cmake option ENABLE_NURBS_DEBUG_VALIDATION) to re-check the cached validity and the data
+// derived with it (rational or not, uniform knot spans, the Euclidean control mesh) on every query. a mismatch means the
+// geometry was modified without telling the curve or surface (see NURBS_Surface::geometryChanged).
+
+// problem found by the validation, the first one wins
+enum NURBSValidationError
+{
+	NURBS_VALID = 0,
+	NURBS_UNSORTED_KNOTS,				// knot index + 1 is smaller than knot index
+	NURBS_KNOT_COUNT_MISMATCH,			// number of control points + degree + 1 != number of knots
+	NURBS_IRREGULAR_CONTROL_NET,		// control row index has another size than row 0
+	NURBS_TOO_FEW_CONTROL_POINTS,		// less than degree + 1 control points in a direction
+	NURBS_DEGREE_NOT_SUPPORTED			// degree > NURBS_MAX_DEGREE
+};
+
+// result of a validation. direction is 'u', 'v' or 0 for curves, index locates the problem (knot or control row).
+struct NURBSValidation
+{
+	NURBSValidationError error;
+	char direction;
+	size_t index;
+
+	NURBSValidation(const NURBSValidationError error_ = NURBS_VALID, const char direction_ = 0, const size_t index_ = 0) : error(error_), direction(direction_), index(index_)
+	{
+	}
+
+	bool isValid() const { return error == NURBS_VALID; }
+
+	bool operator== (const NURBSValidation& other) const { return error == other.error && direction == other.direction && index == other.index; }
+	bool operator!= (const NURBSValidation& other) const { return !(*this == other); }
+};
+
+// validate a knot vector U of degree p for numControlPoints control points (direction 0)
+NURBSValidation validateKnotVector(const std::vector<float>& knotVector, const size_t numControlPoints, const unsigned int degree);
+
+// validate a curve with control points P, knot vector U and degree p
+NURBSValidation validateCurve(const std::vector<Vec4f>& controlPoints, const std::vector<float>& knotVector, const unsigned int degree);
+
+// validate a surface with control mesh P (first index v), knot vectors U and V and degree p
+NURBSValidation validateSurface(const std::vector<std::vector<Vec4f>>& controlPoints, const std::vector<float>& knotVectorU, const std::vector<float>& knotVectorV, const unsigned int degree);
+
+// returns a printable description of the error
+const char* validationErrorName(const NURBSValidationError error);
+
+// prints "valid" or "INVALID (description, direction, index)"
+std::ostream& operator<< (std::ostream& os, const NURBSValidation& validation);
+
+#endif // NURBS_VALIDATION_H
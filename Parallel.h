@@ -0,0 +1,16 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <stdlib.h>			// size_t
+
+#include "JobScheduler.h"
+
+// calls func(begin, end) for chunks of at least minChunkSize indices covering [0, count) on the worker pool of the
+// global job scheduler. the calling thread takes part in the work. returns when all chunks are done.
+template<class Func>
+void parallelFor(const size_t count, const size_t minChunkSize, Func func)
+{
+	JobScheduler::global().parallelFor(count, minChunkSize, func);
+}
+
+#endif // PARALLEL_H
@@ -0,0 +1,205 @@
+#include "Profiler.h"
+
+#ifdef ENABLE_PROFILING
+
+#include <stdio.h>		// fopen, fprintf
+#include <chrono>		// std::chrono::steady_clock
+#include <atomic>		// std::atomic<>
+#include <memory>		// std::shared_ptr<>
+#include <mutex>		// std::mutex
+#include <vector>		// std::vector<>
+
+namespace
+{
+	struct ProfileEvent
+	{
+		const char* name;
+		long long begin;		// ns since program start
+		long long duration;		// ns, -1 for counters
+		double value;			// counter value
+	};
+
+	// slot of a ring buffer. the fields are atomics, so writeChromeTrace may copy a slot while its thread
+	// overwrites it. such torn copies are detected with ThreadBuffer::started and dropped.
+	struct EventSlot
+	{
+		std::atomic<const char*> name;
+		std::atomic<long long> begin;
+		std::atomic<long long> duration;
+		std::atomic<double> value;
+	};
+
+	// ring buffer of one thread. only the owning thread writes, so recording an event takes no lock: it announces the
+	// write in started, fills the slot and publishes it in next (a sequence lock with one writer).
+	struct ThreadBuffer
+	{
+		std::vector<EventSlot> events;
+		std::atomic<size_t> started;	// number of events whose write has begun
+		std::atomic<size_t> next;		// number of completely written events, next % size is the write position
+		unsigned int threadId;			// lane in the trace
+		bool inUse;						// guarded by the registry mutex
+
+		ThreadBuffer(const unsigned int threadId_) : events(PROFILE_EVENTS_PER_THREAD), started(0), next(0), threadId(threadId_), inUse(true)
+		{
+		}
+
+		void push(const ProfileEvent& event)
+		{
+			const size_t index = next.load(std::memory_order_relaxed);
+			started.store(index + 1, std::memory_order_relaxed);
+			// release stores: a reader which sees any of the new values also sees started
+			EventSlot& slot = events[index % events.size()];
+			slot.name.store(event.name, std::memory_order_release);
+			slot.begin.store(event.begin, std::memory_order_release);
+			slot.duration.store(event.duration, std::memory_order_release);
+			slot.value.store(event.value, std::memory_order_release);
+			next.store(index + 1, std::memory_order_release);
+		}
+
+		// appends the recorded events to result, oldest first. may run while the owning thread records.
+		void copy(std::vector<ProfileEvent>& result) const
+		{
+			const size_t size = events.size();
+			const size_t end = next.load(std::memory_order_acquire);
+			const size_t begin = end < size ? 0 : end - size;
+			std::vector<ProfileEvent> copied;
+			copied.reserve(end - begin);
+			for (size_t i = begin; i < end; i++)
+			{
+				const EventSlot& slot = events[i % size];
+				ProfileEvent event = { slot.name.load(std::memory_order_acquire), slot.begin.load(std::memory_order_acquire),
+					slot.duration.load(std::memory_order_acquire), slot.value.load(std::memory_order_acquire) };
+				copied.push_back(event);
+			}
+			// event i is intact if no write into its slot (event i + size or later) has begun meanwhile
+			const size_t overwritten = started.load(std::memory_order_relaxed);
+			for (size_t i = begin; i < end; i++) if (overwritten <= i + size) result.push_back(copied[i - begin]);
+		}
+	};
+
+	// all buffers ever created. buffers of finished threads are handed to new threads, so short lived threads
+	// reuse a few lanes instead of allocating a buffer each.
+	struct Registry
+	{
+		std::mutex mutex;
+		std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+	};
+
+	Registry& registry()
+	{
+		static Registry instance;
+		return instance;
+	}
+
+	// owns the buffer of the calling thread and releases it when the thread ends
+	struct ThreadBufferHandle
+	{
+		std::shared_ptr<ThreadBuffer> buffer;
+
+		ThreadBufferHandle()
+		{
+			Registry& reg = registry();
+			std::lock_guard<std::mutex> lock(reg.mutex);
+			for (auto& candidate : reg.buffers)
+			{
+				if (!candidate->inUse)
+				{
+					candidate->inUse = true;
+					buffer = candidate;
+					return;
+				}
+			}
+			buffer = std::make_shared<ThreadBuffer>((unsigned int)reg.buffers.size());
+			reg.buffers.push_back(buffer);
+		}
+
+		~ThreadBufferHandle()
+		{
+			Registry& reg = registry();
+			std::lock_guard<std::mutex> lock(reg.mutex);
+			buffer->inUse = false;
+		}
+	};
+
+	ThreadBuffer& threadBuffer()
+	{
+		thread_local ThreadBufferHandle handle;
+		return *handle.buffer;
+	}
+
+	const std::chrono::steady_clock::time_point programStart = std::chrono::steady_clock::now();
+
+	// writes name as a json string
+	void writeJsonString(FILE* file, const char* name)
+	{
+		fputc('"', file);
+		for (const char* c = name; *c; c++)
+		{
+			if (*c == '"' || *c == '\\') fputc('\\', file);
+			fputc(*c, file);
+		}
+		fputc('"', file);
+	}
+}
+
+long long profileTimestamp()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - programStart).count();
+}
+
+void profileScope(const char* name, const long long begin, const long long end)
+{
+	ProfileEvent event = { name, begin, end - begin, 0.0 };
+	threadBuffer().push(event);
+}
+
+void profileCounter(const char* name, const double value)
+{
+	ProfileEvent event = { name, profileTimestamp(), -1, value };
+	threadBuffer().push(event);
+}
+
+size_t writeChromeTrace(const char* filename)
+{
+	// the recording threads keep running while their buffers are copied
+	std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+	{
+		Registry& reg = registry();
+		std::lock_guard<std::mutex> lock(reg.mutex);
+		buffers = reg.buffers;
+	}
+	std::vector<std::vector<ProfileEvent>> events(buffers.size());
+	for (size_t b = 0; b < buffers.size(); b++) buffers[b]->copy(events[b]);
+
+	FILE* file = fopen(filename, "w");
+	if (!file) return 0;
+	size_t written = 0;
+	fprintf(file, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+	for (size_t b = 0; b < buffers.size(); b++)
+	{
+		for (const ProfileEvent& event : events[b])
+		{
+			if (written > 0) fprintf(file, ",\n");
+			fprintf(file, "{\"name\":");
+			writeJsonString(file, event.name);
+			// chrome expects microseconds
+			if (event.duration >= 0)
+				fprintf(file, ",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%u}", event.begin * 1e-3, event.duration * 1e-3, buffers[b]->threadId);
+			else
+				fprintf(file, ",\"ph\":\"C\",\"ts\":%.3f,\"pid\":1,\"tid\":%u,\"args\":{\"value\":%g}}", event.begin * 1e-3, buffers[b]->threadId, event.value);
+			written++;
+		}
+	}
+	fprintf(file, "\n]}\n");
+	fclose(file);
+	return written;
+}
+
+#else
+
+size_t writeChromeTrace(const char* /*filename*/)
+{
+	return 0;
+}
+
+#endif // ENABLE_PROFILING
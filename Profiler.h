@@ -0,0 +1,70 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <stdlib.h>			// standard library
+
+// scoped timers and counters for the hot paths.
+// every thread records into its own ring buffer without taking a lock, writeChromeTrace() dumps all buffers as chrome
+// trace event json (open with chrome://tracing or https://ui.perfetto.dev). a scope still costs two clock reads, so place
+// it around batches (a tessellated row range, a list of samples) rather than single samples.
+// the macros compile to nothing unless ENABLE_PROFILING is defined (cmake option ENABLE_PROFILING).
+// names have to be string literals (or otherwise outlive the program), only the pointer is stored.
+
+#ifdef ENABLE_PROFILING
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+// time the enclosing scope
+#define PROFILE_SCOPE(name) ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(name)
+// record the current value of a counter
+#define PROFILE_COUNTER(name, value) profileCounter(name, double(value))
+
+// number of events kept per thread, older events are overwritten
+const size_t PROFILE_EVENTS_PER_THREAD = 1 << 16;
+
+// returns the time since program start in nanoseconds
+long long profileTimestamp();
+
+// store a finished scope of the calling thread
+void profileScope(const char* name, const long long begin, const long long end);
+
+// store a counter value of the calling thread
+void profileCounter(const char* name, const double value);
+
+// records the lifetime of the object as one scope
+class ProfileScope
+{
+
+public:
+
+	explicit ProfileScope(const char* name_) : name(name_), begin(profileTimestamp())
+	{
+	}
+
+	~ProfileScope()
+	{
+		profileScope(name, begin, profileTimestamp());
+	}
+
+private:
+
+	ProfileScope(const ProfileScope&);
+	ProfileScope& operator=(const ProfileScope&);
+
+	const char* name;
+	long long begin;
+
+};
+
+#else
+
+#define PROFILE_SCOPE(name)
+#define PROFILE_COUNTER(name, value)
+
+#endif // ENABLE_PROFILING
+
+// write the recorded events of all threads to filename. returns the number of written events.
+// without ENABLE_PROFILING nothing is recorded and no file is written.
+size_t writeChromeTrace(const char* filename);
+
+#endif // PROFILER_H
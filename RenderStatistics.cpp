@@ -0,0 +1,66 @@
+#include "RenderStatistics.h"
+
+#include <GL/glut.h>
+#include <algorithm>	// std::nth_element, std::max
+
+RenderCounters renderCounters;
+
+FrameTimeWindow::FrameTimeWindow() : count(0), next(0)
+{
+}
+
+void FrameTimeWindow::add(const float milliseconds)
+{
+	times[next] = milliseconds;
+	next = (next + 1) % WINDOW_SIZE;
+	if (count < WINDOW_SIZE) count++;
+}
+
+void FrameTimeWindow::summary(float& mean, float& p95, float& max) const
+{
+	mean = p95 = max = 0.0f;
+	if (count == 0) return;
+	float sorted[WINDOW_SIZE];
+	for (size_t i = 0; i < count; i++)
+	{
+		sorted[i] = times[i];
+		mean += times[i];
+		max = std::max(max, times[i]);
+	}
+	mean /= float(count);
+	size_t k = std::min(count - 1, size_t(0.95f * float(count)));
+	std::nth_element(sorted, sorted + k, sorted + count);
+	p95 = sorted[k];
+}
+
+void drawTextOverlay(const std::vector<std::string>& lines)
+{
+	const int width = glutGet(GLUT_WINDOW_WIDTH);
+	const int height = glutGet(GLUT_WINDOW_HEIGHT);
+	const int lineHeight = 15;
+
+	glPushAttrib(GL_ENABLE_BIT | GL_CURRENT_BIT);
+	glDisable(GL_LIGHTING);
+	glDisable(GL_DEPTH_TEST);
+	// pixel coordinates with the origin in the bottom left corner
+	glMatrixMode(GL_PROJECTION);
+	glPushMatrix();
+	glLoadIdentity();
+	gluOrtho2D(0, width, 0, height);
+	glMatrixMode(GL_MODELVIEW);
+	glPushMatrix();
+	glLoadIdentity();
+
+	glColor3f(1.0f, 1.0f, 0.6f);
+	for (size_t i = 0; i < lines.size(); i++)
+	{
+		glRasterPos2i(8, height - lineHeight * int(i + 1));
+		for (const char c : lines[i]) glutBitmapCharacter(GLUT_BITMAP_8_BY_13, c);
+	}
+
+	glMatrixMode(GL_PROJECTION);
+	glPopMatrix();
+	glMatrixMode(GL_MODELVIEW);
+	glPopMatrix();
+	glPopAttrib();
+}
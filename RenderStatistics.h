@@ -0,0 +1,56 @@
+#ifndef RENDER_STATISTICS_H
+#define RENDER_STATISTICS_H
+
+#include <stdlib.h>			// standard library
+#include <string>			// std::string
+#include <vector>			// std::vector<>
+
+// geometry submitted in the current frame. reset by renderScene, incremented by the drawing functions.
+struct RenderCounters
+{
+	size_t drawCalls;	// glBegin/glEnd blocks
+	size_t triangles;
+
+	RenderCounters() : drawCalls(0), triangles(0)
+	{
+	}
+};
+
+extern RenderCounters renderCounters;
+
+// count one draw call with the given number of triangles
+inline void countDrawCall(const size_t triangles = 0)
+{
+	renderCounters.drawCalls++;
+	renderCounters.triangles += triangles;
+}
+
+// rolling window over the last frame times
+class FrameTimeWindow
+{
+
+public:
+
+	FrameTimeWindow();
+
+	// add the time of one frame in milliseconds (overwrites the oldest one when the window is full)
+	void add(const float milliseconds);
+
+	// mean, 95th percentile and maximum of the window, all 0 if it is empty
+	void summary(float& mean, float& p95, float& max) const;
+
+	size_t size() const { return count; }
+
+private:
+
+	static const size_t WINDOW_SIZE = 120;
+	float times[WINDOW_SIZE];
+	size_t count;
+	size_t next;
+
+};
+
+// draw lines of text in the top left corner of the window (GLUT bitmap font, ignores the current transformation)
+void drawTextOverlay(const std::vector<std::string>& lines);
+
+#endif // RENDER_STATISTICS_H
@@ -1,20 +1,31 @@
 #define RADPERDEG 0.0174533
 
 #include "RenderingCurve.h"
+#include "RenderStatistics.h"
 
 #include <GL/glut.h>
 #include <NURBS_Curve.h>
 #include <algorithm>
 
+// chord tolerance of the drawn curves
+static float curveSamplingTolerance = 0.01f;
+
+void setCurveSamplingTolerance(const float tolerance)
+{
+	curveSamplingTolerance = tolerance;
+}
+
 void drawNURBS(NURBSCurve &nurbsCurve, Vec3f color)
 {
 	// draw NURBS curve
 	// NOT homogenized
 	// ===================================================================================
-	auto points = nurbsCurve.evaluateCurveAt(50).first;
+	std::shared_ptr<const CurvePolyline> polyline = nurbsCurve.getPolyline(curveSamplingTolerance);
+	const std::vector<Vec4f>& points = polyline->points;
 	glColor3fv(&color.x);
 	glBegin(GL_LINE_STRIP);
-	for (auto p : points)
+	countDrawCall();
+	for (const Vec4f& p : points)
 	{
 		glVertex3f(p.x, p.y, p.z);
 	}
@@ -26,10 +37,12 @@ void drawNURBS_H(NURBSCurve &nurbsCurve, Vec3f color)
 	// draw NURBS curve
 	// homogenized
 	// ===================================================================================
-	auto points = nurbsCurve.evaluateCurveAt(50).first;
+	std::shared_ptr<const CurvePolyline> polyline = nurbsCurve.getPolyline(curveSamplingTolerance);
+	const std::vector<Vec4f>& points = polyline->points;
 	glColor3fv(&color.x);
 	glBegin(GL_LINE_STRIP);
-	for (auto p : points)
+	countDrawCall();
+	for (Vec4f p : points)
 	{
 		p = p / p.w;
 		glVertex3f(p.x, p.y, p.z);
@@ -45,12 +58,14 @@ void drawNURBSCtrlPolygon(const NURBSCurve &nurbsCurve, Vec3f color)
 	// =========================================================================================================
 	glColor3fv(&color.x);
 	glBegin(GL_POINTS);
+	countDrawCall();
 	for (auto& cp : nurbsCurve.getControlPoints())
 		glVertex3f(cp.x, cp.y, cp.z);
 	glEnd();
 	color *= 0.7f;
 	glColor3fv(&color.x);
 	glBegin(GL_LINE_STRIP);
+	countDrawCall();
 	for (auto ctrlp : nurbsCurve.getControlPoints())
 	{
 		glVertex3fv(&ctrlp.x);
@@ -66,6 +81,7 @@ void drawNURBSCtrlPolygon_H(const NURBSCurve &nurbsCurve, Vec3f color)
 	// =========================================================================================================
 	glColor3fv(&color.x);
 	glBegin(GL_POINTS);
+	countDrawCall();
 	for (auto ctrlp : nurbsCurve.getControlPoints())
 	{
 		ctrlp = ctrlp / ctrlp.w;
@@ -75,6 +91,7 @@ void drawNURBSCtrlPolygon_H(const NURBSCurve &nurbsCurve, Vec3f color)
 	color *= 0.7f;
 	glColor3fv(&color.x);
 	glBegin(GL_LINE_STRIP);
+	countDrawCall();
 	for (auto ctrlp : nurbsCurve.getControlPoints())
 	{
 		ctrlp = ctrlp / ctrlp.w;
@@ -100,9 +117,9 @@ void renderNURBSEvaluation(NURBSCurve &nurbsCurve, float t)
 	if(!nurbsCurve.isValidNURBS())
 		return;
 
-	auto pointsAndTangents = nurbsCurve.evaluateCurveAt(size_t(50));
-	auto points = pointsAndTangents.first;
-	auto tangents = pointsAndTangents.second;
+	std::shared_ptr<const CurvePolyline> polyline = nurbsCurve.getPolyline(curveSamplingTolerance);
+	const std::vector<Vec4f>& points = polyline->points;
+	const std::vector<Vec4f>& tangents = polyline->tangents;
 
 	if(points.size() > 1 && nurbsCurve.getControlPoints().size() > 1)
 	{
@@ -117,6 +134,7 @@ void renderNURBSEvaluation(NURBSCurve &nurbsCurve, float t)
 		// draw tangents of the not homogenized curve
 		glColor3f(0.5f, 0.35f, 0.0f);
 		glBegin(GL_LINES);
+		countDrawCall();
 		for(unsigned int i = 0; i < tangents.size(); ++i)
 		{
 			auto p = points[i];
@@ -131,6 +149,7 @@ void renderNURBSEvaluation(NURBSCurve &nurbsCurve, float t)
 		// draw tangents of the homogenized curve
 		glColor3f(0.5f, 0.0f, 0.5f);
 		glBegin(GL_LINES);
+		countDrawCall();
 		for(unsigned int i = 0; i < tangents.size(); ++i)
 		{
 			auto p = points[i];
@@ -16,6 +16,9 @@
 
 class NURBSCurve;
 
+// chord tolerance (world units) of the adaptive curve polylines, set from the pixel size of the camera
+void setCurveSamplingTolerance(const float tolerance);
+
 void drawNURBS(NURBSCurve &nurbsCurve, Vec3f color);
 void drawNURBS_H(NURBSCurve &nurbsCurve, Vec3f color);
 void drawNURBSCtrlPolygon(const NURBSCurve &nurbsCurve, Vec3f color);
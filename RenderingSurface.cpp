@@ -2,13 +2,16 @@
 
 #include "RenderingSurface.h"
 #include "RenderingCurve.h"
+#include "Profiler.h"
+#include "RenderStatistics.h"
 
 #include <GL/glut.h>
 #include <NURBS_Curve.h>
 #include <NURBS_Surface.h>
 #include <algorithm>
+#include <memory>
 
-void drawSurfacePoints(const std::vector<Vec4f> &points)
+void drawSurfacePoints(const std::vector<Vec3f> &points)
 {
 	// TODO: draw points of the surface
 	// note: Vec4f provides a method to homogenize a vector
@@ -17,18 +20,20 @@ void drawSurfacePoints(const std::vector<Vec4f> &points)
 
 	// =====================================================
 }
-void drawNormals(const std::vector<Vec4f> &points, const std::vector<Vec3f> &normals)
+void drawNormals(const std::vector<Vec3f> &points, const std::vector<Vec3f> &normals)
 {
 	// TODO: draw normals as lines (homogenized)
 	// note: Vec4f provides a method to homogenize a vector
 	// =====================================================
+	// the tessellation already homogenized the points and normalized the normals
 	glColor3f(0.5f, 0.5f, 0.5f);
 	glBegin(GL_LINES);
-	for (size_t i = 0; i < points.size(); i++)
+	countDrawCall();
+	for (size_t i = 0; i < points.size() && i < normals.size(); i++)
 	{
-		Vec4f p = points.at(i).homogenized();
+		const Vec3f& p = points[i];
+		const Vec3f& n = normals[i];
 		glVertex3f(p.x, p.y, p.z);
-		Vec3f n = normals.at(i).normalized();
 		glVertex3f(p.x + n.x, p.y + n.y, p.z + n.z);
 	}
 	glEnd();
@@ -45,6 +50,7 @@ void drawNURBSSurfaceCtrlP(const NURBS_Surface &surface)
 	for (size_t i = 0; i < size_v; i++)
 	{
 		glBegin(GL_LINE_STRIP);
+		countDrawCall();
 		for (size_t j = 0; j < size_u; j++)
 		{
 			Vec4f p = surface.controlPoints.at(j).at(i).homogenized();
@@ -55,6 +61,7 @@ void drawNURBSSurfaceCtrlP(const NURBS_Surface &surface)
 	for (size_t i = 0; i < size_u; i++)
 	{
 		glBegin(GL_LINE_STRIP);
+		countDrawCall();
 		for (size_t j = 0; j < size_v; j++)
 		{
 			Vec4f p = surface.controlPoints.at(i).at(j).homogenized();
@@ -67,10 +74,16 @@ void drawNURBSSurfaceCtrlP(const NURBS_Surface &surface)
 	// =====================================================
 }
 
-void drawNURBSSurface(std::vector<Vec4f> &points, const std::vector<Vec3f> &normals, const size_t numPointsU, const size_t numPointsV, bool enableSurf, bool enableWire)
+void drawNURBSSurface(const IndexedMesh& mesh, const size_t numPointsU, const size_t numPointsV, bool enableSurf, bool enableWire, const std::vector<Vec3f>* colors /*= nullptr*/)
 {
+	PROFILE_SCOPE("drawNURBSSurface");
+	if (mesh.points.empty()) return;
 
-	if (enableWire)
+	// all passes read the shared vertices of the indexed mesh
+	glEnableClientState(GL_VERTEX_ARRAY);
+	glVertexPointer(3, GL_FLOAT, sizeof(Vec3f), &mesh.points[0].x);
+
+	if (enableWire && mesh.gridVertices.size() == numPointsU * numPointsV)
 	{
 		glDisable(GL_LIGHTING);
 		glColor3f(0.0f,0.0f,1.0f);
@@ -80,21 +93,17 @@ void drawNURBSSurface(std::vector<Vec4f> &points, const std::vector<Vec3f> &norm
 		for (size_t i = 0; i < numPointsU; i++)
 		{
 			glBegin(GL_LINE_STRIP);
+			countDrawCall();
 			for (size_t j = 0; j < numPointsV; j++)
-			{
-				Vec4f p = points.at(i * numPointsV + j).homogenized();
-				glVertex3f(p.x, p.y, p.z);
-			}
+				glArrayElement(mesh.gridVertices[i * numPointsV + j]);
 			glEnd();
 		}
 		for (size_t i = 0; i < numPointsV; i++)
 		{
 			glBegin(GL_LINE_STRIP);
+			countDrawCall();
 			for (size_t j = 0; j < numPointsU; j++)
-			{
-				Vec4f p = points.at(j * numPointsV + i).homogenized();
-				glVertex3f(p.x, p.y, p.z);
-			}
+				glArrayElement(mesh.gridVertices[j * numPointsV + i]);
 			glEnd();
 		}
 
@@ -102,54 +111,50 @@ void drawNURBSSurface(std::vector<Vec4f> &points, const std::vector<Vec3f> &norm
 
 	}
 
-	if (enableSurf)
+	if (enableSurf && !mesh.indices.empty())
 	{
 		glEnable(GL_LIGHTING);
 		glColor3f(0.99f, 0.99f, 0.99f);
 		// TODO: draw surface with quads
 		// =====================================================
 
-		for (size_t i = 0; i < numPointsU - 1; i++)
+		// one call for the welded, cache ordered triangles
+		glEnableClientState(GL_NORMAL_ARRAY);
+		glNormalPointer(GL_FLOAT, sizeof(Vec3f), &mesh.normals[0].x);
+		const bool withColors = colors && colors->size() == mesh.points.size();
+		if (withColors)
 		{
-			glBegin(GL_TRIANGLES);
-			for (size_t j = 0; j < numPointsV - 1; j++)
-			{
-				size_t n1 = i * numPointsV + j;
-				size_t n2 = (i + 1)* numPointsV + j;
-				size_t n3 = i * numPointsV + (j + 1);
-				size_t n4 = (i + 1) * numPointsV + (j + 1);
-				Vec4f p1 = points.at(n1).homogenized();
-				Vec4f p2 = points.at(n2).homogenized();
-				Vec4f p3 = points.at(n3).homogenized();
-				Vec4f p4 = points.at(n4).homogenized();
-
-				Vec3f n = normals.at(n1);
-				n = n + normals.at(n2);
-				n = n + normals.at(n3);
-				n.normalize();
-
-				glNormal3f(n.x, n.y, n.z);
-				glVertex3f(p1.x, p1.y, p1.z);
-				glVertex3f(p2.x, p2.y, p2.z);
-				glVertex3f(p3.x, p3.y, p3.z);
-
-				n = normals.at(n2);
-				n = n + normals.at(n3);
-				n = n + normals.at(n4);
-				n.normalize();
-
-				glVertex3f(p2.x, p2.y, p2.z);
-				glVertex3f(p3.x, p3.y, p3.z);
-				glVertex3f(p4.x, p4.y, p4.z);
-			}
-
-			glEnd();
+			glEnableClientState(GL_COLOR_ARRAY);
+			glColorPointer(3, GL_FLOAT, sizeof(Vec3f), &colors->at(0).x);
 		}
+		glDrawElements(GL_TRIANGLES, (GLsizei)mesh.indices.size(), GL_UNSIGNED_INT, mesh.indices.data());
+		countDrawCall(mesh.indices.size() / 3);
+		if (withColors) glDisableClientState(GL_COLOR_ARRAY);
+		glDisableClientState(GL_NORMAL_ARRAY);
 		
 		
 		// =====================================================
 	}
+	glDisableClientState(GL_VERTEX_ARRAY);
 }
+// curves of the evaluation visualization. the control curves only depend on the surface geometry and the order, the iso
+// curve also on the first parameter, so moving u or v rebuilds as little as possible and the curves keep their cached
+// polylines. the geometry is identified by its epoch, so a changed surface (or another one at the same address) is rebuilt.
+struct EvaluationCurves
+{
+	unsigned long long geometryEpoch;		// of the surface the curves were built from, 0 before the first build
+	bool vFirst;
+	std::vector<NURBSCurve> controlCurves;	// control columns (v first) or rows (u first)
+	float isoParameter;						// v (v first) or u of the iso curve
+	std::unique_ptr<NURBSCurve> isoCurve;	// the iso curve through the control curves at isoParameter
+
+	EvaluationCurves() : geometryEpoch(0), vFirst(true), isoParameter(0.0f)
+	{
+	}
+};
+
+static EvaluationCurves evaluationCurves;
+
 void evaluateNURBSSurface(const NURBS_Surface &surface,float u, float v, bool vFirst /*= true*/)
 {
 	Vec3f colorPolyU =  {1.0f, 0.7f, 0.4f};
@@ -162,97 +167,46 @@ void evaluateNURBSSurface(const NURBS_Surface &surface,float u, float v, bool vF
 	// note: use the NURBSCurve class and the CurveRendering functions 'drawNURBSCtrlPolygon_H' 'drawNURBS_H'
 	// =====================================================
 
-	const size_t size_u = surface.controlPoints.size();
-	const size_t size_v = surface.controlPoints.at(0).size();
-
-	if (vFirst)
+	EvaluationCurves& curves = evaluationCurves;
+	if (curves.geometryEpoch != surface.geometryEpoch() || curves.vFirst != vFirst)
 	{
-		// 1. draw the nurbs curves and its control polygons first in v direction
-		std::vector<Vec4f> points_v;
-		for (size_t i = 0; i < size_v; i++)
-		{
-			std::vector<Vec4f> points_u;
-			for (size_t j = 0; j < size_u; j++)
-			{
-				points_u.push_back(surface.controlPoints.at(j).at(i));
-			}
-
-			NURBSCurve curve = NURBSCurve(points_u, surface.knotVectorV, surface.degree);
-
-
-			drawNURBSCtrlPolygon_H(curve, colorPolyV);
-
-			drawNURBS_H(curve, colorCurveV);
-
-			points_v.push_back(curve.evaluteDeBoor(v, Vec4f()));
-		}
-
-		// 2. then the resulting curve and its control polygon at v in u direction.
-		   
-		NURBSCurve curve = NURBSCurve(points_v, surface.knotVectorU, surface.degree);
-
-		//renderNURBSEvaluation(curve, v);
-
-		drawNURBSCtrlPolygon_H(curve, colorPolyU);
-
-		drawNURBS_H(curve, colorCurveU);
-
-
-		// 3. draw the evaluated surface point
-	
-		glColor3fv(&colorPoint.x);
-		glBegin(GL_POINTS);
-		{
-			Vec4f p = curve.evaluteDeBoor(u, Vec4f()).homogenized();
-			glVertex3f(p.x, p.y, p.z);
-		}
-		glEnd();
-
+		curves.geometryEpoch = surface.geometryEpoch();
+		curves.vFirst = vFirst;
+		curves.controlCurves.clear();
+		curves.isoCurve.reset();
+		// 1. the nurbs curves of the control net first in v direction (columns) or in u direction (rows)
+		const size_t count = vFirst ? surface.controlPoints.at(0).size() : surface.controlPoints.size();
+		for (size_t i = 0; i < count; i++)
+			curves.controlCurves.push_back(vFirst ? surface.controlColumnCurve(i) : surface.controlRowCurve(i));
 	}
-	else
+	// 2. then the resulting iso curve at v in u direction (or at u in v direction)
+	const float isoParameter = vFirst ? v : u;
+	if (!curves.isoCurve || curves.isoParameter != isoParameter)
 	{
-		// 1. draw the nurbs curves and its control polygons first in u direction
-
-		std::vector<Vec4f> points_u;
-		for (size_t i = 0; i < size_u; i++)
-		{
-			NURBSCurve curve = NURBSCurve(surface.controlPoints.at(i), surface.knotVectorU, surface.degree);
-
-			//renderNURBSEvaluation(curve, u);
-			
-
-			drawNURBSCtrlPolygon_H(curve, colorPolyU);
-
-			drawNURBS_H(curve, colorCurveU);
-
-			points_u.push_back(curve.evaluteDeBoor(u, Vec4f()));
-		}
-
-
-		// 2. then the resulting curve and its control polygon at u in v direction.
-
-		NURBSCurve curve = NURBSCurve(points_u, surface.knotVectorV, surface.degree);
-
-		//renderNURBSEvaluation(curve, v);
-
-		drawNURBSCtrlPolygon_H(curve, colorPolyV);
-
-		drawNURBS_H(curve, colorCurveV);
-
-
-		// 3. draw the evaluated surface point
-		
+		curves.isoCurve.reset(new NURBSCurve(vFirst ? surface.extractIsoCurveV(v) : surface.extractIsoCurveU(u)));
+		curves.isoParameter = isoParameter;
+	}
+	NURBSCurve& isoCurve = *curves.isoCurve;
 
-		glColor3fv(&colorPoint.x);
-		glBegin(GL_POINTS);
-		{
-			Vec4f p = curve.evaluteDeBoor(v, Vec4f()).homogenized();
-			glVertex3f(p.x, p.y, p.z);
-		}
-		glEnd();
+	for (NURBSCurve& curve : curves.controlCurves)
+	{
+		drawNURBSCtrlPolygon_H(curve, vFirst ? colorPolyV : colorPolyU);
+		drawNURBS_H(curve, vFirst ? colorCurveV : colorCurveU);
+	}
+	drawNURBSCtrlPolygon_H(isoCurve, vFirst ? colorPolyU : colorPolyV);
+	drawNURBS_H(isoCurve, vFirst ? colorCurveU : colorCurveV);
+
+	// 3. draw the evaluated surface point
+	if (isoCurve.getControlPoints().empty()) return;
+	glColor3fv(&colorPoint.x);
+	glBegin(GL_POINTS);
+	countDrawCall();
+	{
+		Vec4f tangent;
+		Vec4f p = isoCurve.evaluteDeBoor(vFirst ? u : v, tangent).homogenized();
+		glVertex3f(p.x, p.y, p.z);
 	}
+	glEnd();
 
 	// =====================================================
-
-	
 }
@@ -14,13 +14,19 @@
 #include <Vec4.h>
 #include <vector>
 
+#include "MeshOptimization.h"
+
 class NURBS_Surface;
 
-void drawSurfacePoints(const std::vector<Vec4f> &points);
-void drawNormals(const std::vector<Vec4f> &points, const std::vector<Vec3f> &normals);
+// points and normals of a tessellation (euclidean points, unit normals)
+void drawSurfacePoints(const std::vector<Vec3f> &points);
+void drawNormals(const std::vector<Vec3f> &points, const std::vector<Vec3f> &normals);
 void drawNURBSSurfaceCtrlP(const NURBS_Surface &surface);
 
-void drawNURBSSurface(std::vector<Vec4f>& points, const std::vector<Vec3f>& normals, const size_t numPointsU, const size_t numPointsV, bool enableSurf, bool enableWire);
+// draws the indexed mesh of a numPointsU x numPointsV grid. colors are per vertex of the mesh.
+void drawNURBSSurface(const IndexedMesh& mesh, const size_t numPointsU, const size_t numPointsV, bool enableSurf, bool enableWire, const std::vector<Vec3f>* colors = nullptr);
+// draws the control curves, the iso curve and the point of the evaluation at (u, v). the curves are cached and only
+// rebuilt when the surface, the order or the parameter of the iso curve change.
 void evaluateNURBSSurface(const NURBS_Surface &surface, float u, float v, bool vFirst = true);
 
 #endif //
\ No newline at end of file
@@ -0,0 +1,80 @@
+#include "SceneTessellation.h"
+
+#include <algorithm>	// std::min, std::max
+#include <chrono>		// timing
+
+#include "CurvatureAnalysis.h"
+#include "Profiler.h"
+
+// jobs per thread of the scheduler, more jobs balance better but cost more scheduling
+static const size_t JOBS_PER_THREAD = 4;
+
+double tessellationRowCost(const NURBS_Surface& surface, const size_t numPointsV)
+{
+	const double degree = (double)std::max(surface.degree, 1u);
+	return (double)numPointsV * degree * degree;
+}
+
+size_t tessellateScene(const std::vector<SceneSurface>& surfaces, const TessellationMode mode, JobScheduler& scheduler, std::vector<std::shared_ptr<TessellationResult>>& results)
+{
+	PROFILE_SCOPE("tessellateScene");
+	auto start = std::chrono::high_resolution_clock::now();
+	results.assign(surfaces.size(), nullptr);
+
+	// prepare the buffers and sum up the estimated cost
+	std::vector<double> rowCosts(surfaces.size(), 0.0);
+	double totalCost = 0.0;
+	for (size_t s = 0; s < surfaces.size(); s++)
+	{
+		const NURBS_Surface& surface = *surfaces[s].surface;
+		if (!canTessellate(surface)) continue;
+		std::shared_ptr<TessellationResult> result(new TessellationResult());
+		result->surfaceIndex = s;
+		result->numLevels = 1;
+		result->parametersU = gridParameters(surfaces[s].resolutionU);
+		result->parametersV = gridParameters(surfaces[s].resolutionV);
+		prepareMesh(result->parametersU, result->parametersV, result->mesh);
+		prepareCurvatureMaps(result->parametersU, result->parametersV, result->curvatureMaps);
+		rowCosts[s] = tessellationRowCost(surface, result->parametersV.size());
+		totalCost += rowCosts[s] * (double)result->parametersU.size();
+		results[s] = result;
+	}
+
+	// cut every surface into row ranges of about the target cost
+	const double targetCost = totalCost / (double)(scheduler.concurrency() * JOBS_PER_THREAD);
+	std::vector<Job> jobs;
+	for (size_t s = 0; s < surfaces.size(); s++)
+	{
+		if (!results[s]) continue;
+		TessellationResult* result = results[s].get();
+		const NURBS_Surface* surface = surfaces[s].surface;
+		const size_t numRows = result->parametersU.size();
+		const size_t rowsPerJob = std::max(size_t(1), (size_t)(targetCost / std::max(rowCosts[s], 1.0)));
+		for (size_t rowBegin = 0; rowBegin < numRows; rowBegin += rowsPerJob)
+		{
+			const size_t rowEnd = std::min(rowBegin + rowsPerJob, numRows);
+			jobs.push_back(Job(rowCosts[s] * (double)(rowEnd - rowBegin), [=]()
+			{
+				tessellateRows(*surface, result->parametersU, result->parametersV, rowBegin, rowEnd, mode, result->mesh);
+				computeCurvatureRows(*surface, result->parametersU, result->parametersV, rowBegin, rowEnd, result->curvatureMaps);
+			}));
+		}
+	}
+	scheduler.run(jobs);
+
+	// weld and order the finished meshes, one job per surface
+	std::vector<Job> indexJobs;
+	for (size_t s = 0; s < surfaces.size(); s++)
+	{
+		if (!results[s]) continue;
+		TessellationResult* result = results[s].get();
+		indexJobs.push_back(Job((double)result->mesh.points.size(), [result]() { buildIndexedMesh(result->mesh, result->indexedMesh); }));
+	}
+	scheduler.run(indexJobs);
+
+	// attribute the time to the surfaces by their share of the cost
+	const double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+	for (size_t s = 0; s < surfaces.size(); s++)
+		if (results[s] && totalCost > 0.0) results[s]->milliseconds = milliseconds * rowCosts[s] * (double)results[s]->parametersU.size() / totalCost;
+	return jobs.size();
+}
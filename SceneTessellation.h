@@ -0,0 +1,33 @@
+#ifndef SCENE_TESSELLATION_H
+#define SCENE_TESSELLATION_H
+
+#include <stdlib.h>			// standard library
+#include <memory>			// std::shared_ptr<>
+#include <vector>			// std::vector<>
+
+#include "AsyncTessellation.h"
+#include "JobScheduler.h"
+#include "NURBS_Surface.h"
+#include "Tessellation.h"
+
+// a surface of the scene and its sampling
+struct SceneSurface
+{
+	const NURBS_Surface* surface;
+	float resolutionU;
+	float resolutionV;
+
+	SceneSurface(const NURBS_Surface* surface_, const float resolutionU_, const float resolutionV_) : surface(surface_), resolutionU(resolutionU_), resolutionV(resolutionV_)
+	{
+	}
+};
+
+// estimated cost of tessellating one grid row of surface with numPointsV samples (samples x degree^2)
+double tessellationRowCost(const NURBS_Surface& surface, const size_t numPointsV);
+
+// tessellate all surfaces (points, normals, curvature maps and indexed meshes) on the scheduler. the rows of all surfaces are cut
+// into ranges of similar estimated cost instead of one job per surface, so a few large surfaces spread over all cores.
+// results[i] belongs to surfaces[i] and is nullptr if the surface can not be tessellated. returns the number of jobs.
+size_t tessellateScene(const std::vector<SceneSurface>& surfaces, const TessellationMode mode, JobScheduler& scheduler, std::vector<std::shared_ptr<TessellationResult>>& results);
+
+#endif // SCENE_TESSELLATION_H
@@ -0,0 +1,54 @@
+// headless concurrent evaluation stress test (the same as key X of main). build with ENABLE_THREAD_SANITIZER and run it
+// in CI: the exit code is 1 if any thread got a result which differs from the single threaded reference.
+
+#include <stdlib.h>		// EXIT_SUCCESS, EXIT_FAILURE
+#include <cmath>		// sin, cos
+#include <iostream>		// cout
+#include <algorithm>	// std::max
+#include <thread>		// std::thread::hardware_concurrency
+
+#include "ConcurrencyStress.h"
+
+// clamped uniform knot vector for numControlPoints control points of degree p
+static std::vector<float> clampedUniformKnots(const size_t numControlPoints, const unsigned int p)
+{
+	std::vector<float> knots(p, 0.0f);
+	for (size_t i = 0; i <= numControlPoints - p; i++) knots.push_back(float(i) / float(numControlPoints - p));
+	knots.insert(knots.end(), p, 1.0f);
+	return knots;
+}
+
+// bicubic height field on a clamped uniform 8 x 8 control mesh, weighted if rational
+static NURBS_Surface heightField(const bool rational)
+{
+	const size_t size = 8;
+	std::vector<std::vector<Vec4f>> controlPoints(size, std::vector<Vec4f>(size));
+	for (size_t r = 0; r < size; r++)
+	{
+		for (size_t c = 0; c < size; c++)
+		{
+			const float w = rational ? 1.0f + 0.5f * float((r + 2 * c) % 3) : 1.0f;
+			controlPoints[r][c] = Vec4f(float(c), float(r), sinf(float(c)) * cosf(float(r)), 1.0f) * w;
+		}
+	}
+	return NURBS_Surface(controlPoints, clampedUniformKnots(size, 3), clampedUniformKnots(size, 3), 3);
+}
+
+int main(int /*argc*/, char** /*argv*/)
+{
+	const unsigned int numThreads = std::max(std::thread::hardware_concurrency(), 8u);
+	const unsigned int iterations = 4;
+	const NURBS_Surface surfaces[3] = { NURBS_Surface(), heightField(false), heightField(true) };
+	const char* names[3] = { "quarter cylinder", "polynomial height field", "rational height field" };
+	size_t mismatches = 0;
+	for (unsigned int i = 0; i < 3; i++)
+	{
+		ConcurrencyStressResult result = runConcurrencyStress(surfaces[i], numThreads, iterations);
+		std::cout << names[i] << ": " << result.numThreads << " threads x " << result.samplesPerThread << " samples in " << result.milliseconds << " ms, "
+			<< result.mismatches << " results differ from the single threaded reference" << std::endl;
+		if (!surfaces[i].isValidNURBS()) std::cout << "  invalid surface: " << surfaces[i].validation() << std::endl;
+		mismatches += result.mismatches;
+		if (!surfaces[i].isValidNURBS()) mismatches++;
+	}
+	return mismatches == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
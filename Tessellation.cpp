@@ -0,0 +1,203 @@
+#include "Tessellation.h"
+
+#include <algorithm>	// std::max
+#include <cmath>		// fabs, sqrt
+
+#include "NURBS_Basis.h"
+#include "NURBS_PowerBasis.h"
+#include "Profiler.h"
+
+// forward difference table of a (homogeneous) polynomial sampled with a constant step.
+// D[k] is the k-th forward difference at the current sample, D[0] the value itself.
+struct ForwardDifferences
+{
+	Vec4f D[NURBS_MAX_DEGREE + 1];
+	unsigned int degree;
+
+	// build the table from degree + 1 consecutive samples
+	void initialize(const Vec4f* samples, const unsigned int degree_)
+	{
+		degree = degree_;
+		for (unsigned int k = 0; k <= degree; k++) D[k] = samples[k];
+		for (unsigned int level = 1; level <= degree; level++)
+			for (unsigned int k = degree; k >= level; k--) D[k] -= D[k - 1];
+	}
+
+	// advance to the next sample with degree additions
+	void step()
+	{
+		for (unsigned int k = 0; k < degree; k++) D[k] += D[k + 1];
+	}
+};
+
+// scale the normals to unit length, degenerate ones become zero. no branches, so the loop vectorizes.
+static void normalizeNormals(Vec3f* normals, const size_t count)
+{
+	for (size_t i = 0; i < count; i++)
+	{
+		const float squaredLength = normals[i].x * normals[i].x + normals[i].y * normals[i].y + normals[i].z * normals[i].z;
+		const float inverseLength = squaredLength > 1e-20f ? 1.0f / std::sqrt(squaredLength) : 0.0f;
+		normals[i].x *= inverseLength;
+		normals[i].y *= inverseLength;
+		normals[i].z *= inverseLength;
+	}
+}
+
+bool canTessellate(const NURBS_Surface& surface)
+{
+	return surface.isValidNURBS();
+}
+
+std::vector<float> gridParameters(const float resolution)
+{
+	std::vector<float> parameters;
+	for (float t = 0; t <= 1.0f; t += resolution) parameters.push_back(t);
+	return parameters;
+}
+
+void prepareMesh(const std::vector<float>& parametersU, const std::vector<float>& parametersV, TessellatedMesh& mesh)
+{
+	mesh.numPointsU = parametersU.size();
+	mesh.numPointsV = parametersV.size();
+	mesh.points.resize(mesh.numPointsU * mesh.numPointsV);
+	mesh.normals.resize(mesh.numPointsU * mesh.numPointsV);
+}
+
+static void tessellateRowsExact(const NURBS_Surface& surface, const std::vector<float>& parametersU, const std::vector<float>& parametersV, const size_t rowBegin, const size_t rowEnd, TessellatedMesh& mesh)
+{
+	// the rows are a grid of their own, written straight into the mesh
+	const size_t offset = rowBegin * parametersV.size();
+	const std::vector<float> rowsU(parametersU.begin() + rowBegin, parametersU.begin() + rowEnd);
+	surface.evaluateSurfaceAtGrid(rowsU, parametersV, SurfaceSampleBuffers(mesh.points.data() + offset, nullptr, nullptr, mesh.normals.data() + offset));
+}
+
+static void tessellateRowsPowerBasis(const NURBS_Surface& surface, const std::vector<float>& parametersU, const std::vector<float>& parametersV, const size_t rowBegin, const size_t rowEnd, TessellatedMesh& mesh)
+{
+	const size_t offset = rowBegin * parametersV.size();
+	const std::vector<float> rowsU(parametersU.begin() + rowBegin, parametersU.begin() + rowEnd);
+	surface.getPowerBasis()->evaluateGrid(rowsU, parametersV, SurfaceSampleBuffers(mesh.points.data() + offset, nullptr, nullptr, mesh.normals.data() + offset));
+}
+
+static void tessellateRowsForwardDifferences(const NURBS_Surface& surface, const std::vector<float>& parametersU, const std::vector<float>& parametersV, const size_t rowBegin, const size_t rowEnd, const unsigned int resetInterval, TessellatedMesh& mesh)
+{
+	const unsigned int p = surface.degree;
+	const size_t numRows = surface.controlPoints.size();
+	const size_t numPointsV = parametersV.size();
+	if (numPointsV == 0) return;
+	// knot spans of the samples in v direction are the same for all rows, and so are the restarts:
+	// at the first sample, at span changes and where the step differs from the one of the restart
+	std::vector<int> spans(numPointsV);
+	for (size_t j = 0; j < numPointsV; j++) spans[j] = findSpan(surface.knotVectorV, p, numRows, parametersV[j]);
+	std::vector<char> restart(numPointsV, 0);
+	std::vector<float> steps(numPointsV, 0.0f);
+	float h = 0.0f;
+	for (size_t j = 0; j < numPointsV; j++)
+	{
+		if (j == 0 || spans[j] != spans[j - 1] || std::fabs(parametersV[j] - parametersV[j - 1] - h) > 1e-3f * h)
+		{
+			restart[j] = 1;
+			h = j + 1 < numPointsV ? parametersV[j + 1] - parametersV[j] : 0.0f;
+		}
+		steps[j] = h;
+	}
+
+	std::vector<Vec4f> Q(numRows);		// control points of the iso curve at u
+	std::vector<Vec4f> Qu(numRows);		// their derivatives in u direction
+	float Nu[2 * (NURBS_MAX_DEGREE + 1)];
+	float Nv[2 * (NURBS_MAX_DEGREE + 1)];
+	for (size_t i = rowBegin; i < rowEnd; i++)
+	{
+		const float u = parametersU[i];
+		int spanU = findSpan(surface.knotVectorU, p, surface.controlPoints[0].size(), u);
+		basisFunctionDerivatives(surface.knotVectorU, p, spanU, u, 1, Nu);
+		for (size_t r = 0; r < numRows; r++)
+		{
+			Vec4f q;
+			Vec4f qu;
+			for (unsigned int k = 0; k <= p; k++)
+			{
+				const Vec4f& P = surface.controlPoints[r][spanU - p + k];
+				q += P * Nu[k];
+				qu += P * Nu[p + 1 + k];
+			}
+			Q[r] = q;
+			Qu[r] = qu;
+		}
+		// homogeneous point A, its partial derivative Au in u (both degree p in v) and Av in v (degree p - 1)
+		ForwardDifferences A;
+		ForwardDifferences Au;
+		ForwardDifferences Av;
+		unsigned int sinceReset = 0;
+		for (size_t j = 0; j < numPointsV; j++)
+		{
+			if (restart[j] || sinceReset >= resetInterval)
+			{
+				// restart from exact samples of the span polynomials at v_j, v_j + h, ..., v_j + p * h
+				Vec4f a[NURBS_MAX_DEGREE + 1];
+				Vec4f au[NURBS_MAX_DEGREE + 1];
+				Vec4f av[NURBS_MAX_DEGREE + 1];
+				const int span = spans[j];
+				for (unsigned int m = 0; m <= p; m++)
+				{
+					basisFunctionDerivatives(surface.knotVectorV, p, span, parametersV[j] + float(m) * steps[j], 1, Nv);
+					for (unsigned int k = 0; k <= p; k++)
+					{
+						a[m] += Q[span - p + k] * Nv[k];
+						au[m] += Qu[span - p + k] * Nv[k];
+						av[m] += Q[span - p + k] * Nv[p + 1 + k];
+					}
+				}
+				A.initialize(a, p);
+				Au.initialize(au, p);
+				Av.initialize(av, p - 1);
+				sinceReset = 0;
+			}
+			else
+			{
+				A.step();
+				Au.step();
+				Av.step();
+			}
+			sinceReset++;
+			// quotient rule for the rational surface
+			const Vec4f& a = A.D[0];
+			const Vec4f& au = Au.D[0];
+			const Vec4f& av = Av.D[0];
+			Vec3f S = Vec3f(a.x, a.y, a.z) / a.w;
+			Vec3f Su = (Vec3f(au.x, au.y, au.z) - S * au.w) / a.w;
+			Vec3f Sv = (Vec3f(av.x, av.y, av.z) - S * av.w) / a.w;
+			size_t n = i * numPointsV + j;
+			mesh.points[n] = S;
+			mesh.normals[n] = Su ^ Sv;
+		}
+		normalizeNormals(&mesh.normals[i * numPointsV], numPointsV);
+	}
+}
+
+void tessellateRows(const NURBS_Surface& surface, const std::vector<float>& parametersU, const std::vector<float>& parametersV, const size_t rowBegin, const size_t rowEnd, const TessellationMode mode, TessellatedMesh& mesh, const unsigned int resetInterval /*= 8*/)
+{
+	PROFILE_SCOPE("tessellateRows");
+	if (mode == TESSELLATION_FORWARD_DIFFERENCES && surface.degree >= 1)
+		tessellateRowsForwardDifferences(surface, parametersU, parametersV, rowBegin, rowEnd, std::max(resetInterval, 1u), mesh);
+	else if (mode == TESSELLATION_POWER_BASIS)
+		tessellateRowsPowerBasis(surface, parametersU, parametersV, rowBegin, rowEnd, mesh);
+	else
+		tessellateRowsExact(surface, parametersU, parametersV, rowBegin, rowEnd, mesh);
+}
+
+void tessellateSurface(const NURBS_Surface& surface, const std::vector<float>& parametersU, const std::vector<float>& parametersV, const TessellationMode mode, TessellatedMesh& mesh)
+{
+	prepareMesh(parametersU, parametersV, mesh);
+	tessellateRows(surface, parametersU, parametersV, 0, parametersU.size(), mode, mesh);
+}
+
+const char* tessellationModeName(const TessellationMode mode)
+{
+	switch (mode)
+	{
+	case TESSELLATION_EXACT: return "exact de Boor";
+	case TESSELLATION_FORWARD_DIFFERENCES: return "forward differences";
+	case TESSELLATION_POWER_BASIS: return "power basis";
+	default: return "unknown";
+	}
+}
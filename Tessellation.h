@@ -0,0 +1,54 @@
+#ifndef TESSELLATION_H
+#define TESSELLATION_H
+
+#include <stdlib.h>			// standard library
+#include <vector>			// std::vector<>
+
+#include "NURBS_Surface.h"
+#include "Vec3.h"
+#include "Vec4.h"
+
+// evaluator used for the tessellation
+enum TessellationMode
+{
+	TESSELLATION_EXACT = 0,				// de Boor evaluation of every sample
+	TESSELLATION_FORWARD_DIFFERENCES,	// forward differencing along the rows within each knot span
+	TESSELLATION_POWER_BASIS,			// Horner evaluation of the cached power basis form of the surface
+	TESSELLATION_MODE_COUNT
+};
+
+// tessellated surface: euclidean points and unit normals on a grid, index u * numPointsV + v.
+// the normal is zero where the surface is degenerate (e.g. at poles).
+struct TessellatedMesh
+{
+	std::vector<Vec3f> points;
+	std::vector<Vec3f> normals;
+	size_t numPointsU;
+	size_t numPointsV;
+
+	TessellatedMesh() : numPointsU(0), numPointsV(0)
+	{
+	}
+};
+
+// returns true if the control net, knot vectors and degree of surface fit together (the cached validity of the surface)
+bool canTessellate(const NURBS_Surface& surface);
+
+// returns the sample parameters 0, resolution, 2 * resolution, ... <= 1
+std::vector<float> gridParameters(const float resolution);
+
+// resize the mesh for the grid parametersU x parametersV
+void prepareMesh(const std::vector<float>& parametersU, const std::vector<float>& parametersV, TessellatedMesh& mesh);
+
+// evaluate the grid rows (fixed u) [rowBegin, rowEnd) into the prepared mesh. rows may be evaluated concurrently.
+// forward differencing is fastest for equidistant parametersV. it restarts from an exact evaluation at every knot span
+// boundary, where the step changes and after resetInterval samples to bound the accumulated error.
+void tessellateRows(const NURBS_Surface& surface, const std::vector<float>& parametersU, const std::vector<float>& parametersV, const size_t rowBegin, const size_t rowEnd, const TessellationMode mode, TessellatedMesh& mesh, const unsigned int resetInterval = 8);
+
+// tessellate the whole grid parametersU x parametersV
+void tessellateSurface(const NURBS_Surface& surface, const std::vector<float>& parametersU, const std::vector<float>& parametersV, const TessellationMode mode, TessellatedMesh& mesh);
+
+// returns a printable name of the tessellation mode
+const char* tessellationModeName(const TessellationMode mode);
+
+#endif // TESSELLATION_H
@@ -0,0 +1,138 @@
+#include "TessellationCache.h"
+
+// 64 bit FNV-1a
+static const TessellationKey FNV_OFFSET_BASIS = 14695981039346656037ull;
+static const TessellationKey FNV_PRIME = 1099511628211ull;
+
+static void hashBytes(TessellationKey& hash, const void* data, const size_t size)
+{
+	const unsigned char* bytes = (const unsigned char*)data;
+	for (size_t i = 0; i < size; i++)
+	{
+		hash ^= bytes[i];
+		hash *= FNV_PRIME;
+	}
+}
+
+template<class T>
+static void hashValue(TessellationKey& hash, const T& value)
+{
+	hashBytes(hash, &value, sizeof(T));
+}
+
+// hash the size as well, so e.g. moving a knot from one vector into the other changes the key
+static void hashFloats(TessellationKey& hash, const std::vector<float>& values)
+{
+	hashValue(hash, (unsigned long long)values.size());
+	if (!values.empty()) hashBytes(hash, values.data(), values.size() * sizeof(float));
+}
+
+TessellationKey tessellationKey(const NURBS_Surface& surface, const float resolutionU, const float resolutionV, const TessellationMode mode)
+{
+	TessellationKey hash = FNV_OFFSET_BASIS;
+	hashValue(hash, surface.degree);
+	hashFloats(hash, surface.knotVectorU);
+	hashFloats(hash, surface.knotVectorV);
+	hashValue(hash, (unsigned long long)surface.controlPoints.size());
+	for (const std::vector<Vec4f>& row : surface.controlPoints)
+	{
+		hashValue(hash, (unsigned long long)row.size());
+		for (const Vec4f& P : row)
+		{
+			float xyzw[4] = { P.x, P.y, P.z, P.w };
+			hashBytes(hash, xyzw, sizeof(xyzw));
+		}
+	}
+	hashValue(hash, resolutionU);
+	hashValue(hash, resolutionV);
+	hashValue(hash, (int)mode);
+	return hash;
+}
+
+size_t tessellationResultBytes(const TessellationResult& result)
+{
+	const CurvatureMaps& maps = result.curvatureMaps;
+	const IndexedMesh& indexed = result.indexedMesh;
+	return sizeof(TessellationResult)
+		+ (result.mesh.points.capacity() + result.mesh.normals.capacity()) * sizeof(Vec3f)
+		+ (result.parametersU.capacity() + result.parametersV.capacity()) * sizeof(float)
+		+ (maps.gaussian.capacity() + maps.mean.capacity() + maps.maxPrincipal.capacity() + maps.minPrincipal.capacity()) * sizeof(float)
+		+ (indexed.points.capacity() + indexed.normals.capacity()) * sizeof(Vec3f)
+		+ (indexed.indices.capacity() + indexed.gridVertices.capacity() + indexed.vertexSamples.capacity()) * sizeof(unsigned int);
+}
+
+TessellationCache::TessellationCache(const size_t byteBudget_ /*= 256 * 1024 * 1024*/) : bytes(0), byteBudget(byteBudget_), hits(0), misses(0), evictions(0)
+{
+}
+
+std::shared_ptr<const TessellationResult> TessellationCache::find(const TessellationKey key)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	auto it = lookup.find(key);
+	if (it == lookup.end())
+	{
+		misses++;
+		return nullptr;
+	}
+	hits++;
+	entries.splice(entries.begin(), entries, it->second);
+	return it->second->second;
+}
+
+void TessellationCache::insert(const TessellationKey key, const std::shared_ptr<const TessellationResult>& result)
+{
+	const size_t size = tessellationResultBytes(*result);
+	std::lock_guard<std::mutex> lock(mutex);
+	auto it = lookup.find(key);
+	if (it != lookup.end())
+	{
+		bytes -= tessellationResultBytes(*it->second->second);
+		entries.erase(it->second);
+		lookup.erase(it);
+	}
+	if (size > byteBudget) return;
+	entries.push_front(Entry(key, result));
+	lookup[key] = entries.begin();
+	bytes += size;
+	evict();
+}
+
+void TessellationCache::setByteBudget(const size_t byteBudget_)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	byteBudget = byteBudget_;
+	evict();
+}
+
+void TessellationCache::clear()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	entries.clear();
+	lookup.clear();
+	bytes = 0;
+}
+
+TessellationCacheStatistics TessellationCache::statistics() const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	TessellationCacheStatistics stats;
+	stats.hits = hits;
+	stats.misses = misses;
+	stats.evictions = evictions;
+	stats.entries = entries.size();
+	stats.bytes = bytes;
+	stats.byteBudget = byteBudget;
+	return stats;
+}
+
+void TessellationCache::evict()
+{
+	while (bytes > byteBudget && !entries.empty())
+	{
+		const Entry& oldest = entries.back();
+		bytes -= tessellationResultBytes(*oldest.second);
+		lookup.erase(oldest.first);
+		entries.pop_back();
+		evictions++;
+	}
+}
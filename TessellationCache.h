@@ -0,0 +1,74 @@
+#ifndef TESSELLATION_CACHE_H
+#define TESSELLATION_CACHE_H
+
+#include <stdlib.h>			// standard library
+#include <list>				// std::list<>
+#include <memory>			// std::shared_ptr<>
+#include <mutex>			// std::mutex
+#include <unordered_map>	// std::unordered_map<>
+
+#include "AsyncTessellation.h"
+#include "NURBS_Surface.h"
+#include "Tessellation.h"
+
+// content hash of a tessellation: 64 bit FNV-1a over degree, knot vectors, control net, sampling resolutions and evaluator
+typedef unsigned long long TessellationKey;
+
+// returns the key of the tessellation of surface with the given resolutions and mode
+TessellationKey tessellationKey(const NURBS_Surface& surface, const float resolutionU, const float resolutionV, const TessellationMode mode);
+
+// bytes held by the buffers of a tessellation result
+size_t tessellationResultBytes(const TessellationResult& result);
+
+struct TessellationCacheStatistics
+{
+	size_t hits;
+	size_t misses;
+	size_t evictions;
+	size_t entries;
+	size_t bytes;		// bytes held by the cached results
+	size_t byteBudget;
+};
+
+// in-memory cache of finished tessellations. the least recently used entries are evicted when the cached results exceed
+// the byte budget. results are shared and immutable, so a result handed out stays valid after its eviction.
+class TessellationCache
+{
+
+public:
+
+	explicit TessellationCache(const size_t byteBudget_ = 256 * 1024 * 1024);
+
+	// returns the cached result (and marks it as most recently used) or nullptr. counts a hit or miss.
+	std::shared_ptr<const TessellationResult> find(const TessellationKey key);
+
+	// add or replace the result of key. results larger than the whole budget are not cached.
+	void insert(const TessellationKey key, const std::shared_ptr<const TessellationResult>& result);
+
+	// change the budget, evicts entries if necessary
+	void setByteBudget(const size_t byteBudget_);
+
+	// drop all entries (statistics are kept)
+	void clear();
+
+	TessellationCacheStatistics statistics() const;
+
+private:
+
+	typedef std::pair<TessellationKey, std::shared_ptr<const TessellationResult>> Entry;
+
+	// evict least recently used entries until the budget holds. the mutex has to be locked.
+	void evict();
+
+	mutable std::mutex mutex;
+	std::list<Entry> entries;		// most recently used first
+	std::unordered_map<TessellationKey, std::list<Entry>::iterator> lookup;
+	size_t bytes;
+	size_t byteBudget;
+	size_t hits;
+	size_t misses;
+	size_t evictions;
+
+};
+
+#endif // TESSELLATION_CACHE_H
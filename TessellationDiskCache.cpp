@@ -0,0 +1,420 @@
+#include "TessellationDiskCache.h"
+
+#include <stdio.h>		// fopen, rename, remove, snprintf
+#include <string.h>		// memcpy, memcmp
+#include <algorithm>	// std::sort
+#include <vector>		// std::vector<>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <dirent.h>		// opendir, readdir
+#include <fcntl.h>		// open
+#include <sys/mman.h>	// mmap
+#include <sys/stat.h>	// stat, mkdir
+#include <sys/time.h>	// utimes
+#include <unistd.h>		// close, getpid
+#endif
+
+static_assert(sizeof(Vec3f) == 3 * sizeof(float), "Vec3f has to be 3 packed floats to be copied from the file");
+
+static const char BLOB_MAGIC[4] = { 'G', 'T', 'E', 'S' };
+static const char* BLOB_EXTENSION = ".tess";
+
+// file layout: header, points (3 floats each), normals (3 floats each), parametersU, parametersV,
+// curvature maps (gaussian, mean, maxPrincipal, minPrincipal with numPointsU * numPointsV floats each),
+// indexed mesh (vertex points and normals, indices, grid vertices with numPointsU * numPointsV entries, vertex samples)
+struct BlobHeader
+{
+	char magic[4];
+	unsigned int evaluatorVersion;
+	unsigned long long key;
+	unsigned long long numPointsU;
+	unsigned long long numPointsV;
+	unsigned long long numCurvatures;	// 0 if the curvature maps are not stored
+	double milliseconds;
+	unsigned long long numVertices;		// of the indexed mesh, 0 if it is not stored
+	unsigned long long numIndices;
+	float gridACMR;
+	float optimizedACMR;
+};
+
+// ==================
+// === MappedFile ===
+// ==================
+
+#ifdef _WIN32
+
+MappedFile::MappedFile() : bytes(nullptr), length(0), fileHandle(INVALID_HANDLE_VALUE), mappingHandle(nullptr)
+{
+}
+
+bool MappedFile::open(const std::string& filename)
+{
+	close();
+	HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE) return false;
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0)
+	{
+		CloseHandle(file);
+		return false;
+	}
+	HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (!mapping)
+	{
+		CloseHandle(file);
+		return false;
+	}
+	const void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	if (!view)
+	{
+		CloseHandle(mapping);
+		CloseHandle(file);
+		return false;
+	}
+	fileHandle = file;
+	mappingHandle = mapping;
+	bytes = (const unsigned char*)view;
+	length = (size_t)fileSize.QuadPart;
+	return true;
+}
+
+void MappedFile::close()
+{
+	if (bytes) UnmapViewOfFile(bytes);
+	if (mappingHandle) CloseHandle(mappingHandle);
+	if (fileHandle != INVALID_HANDLE_VALUE) CloseHandle(fileHandle);
+	bytes = nullptr;
+	length = 0;
+	mappingHandle = nullptr;
+	fileHandle = INVALID_HANDLE_VALUE;
+}
+
+#else
+
+MappedFile::MappedFile() : bytes(nullptr), length(0)
+{
+}
+
+bool MappedFile::open(const std::string& filename)
+{
+	close();
+	int file = ::open(filename.c_str(), O_RDONLY);
+	if (file < 0) return false;
+	struct stat info;
+	if (fstat(file, &info) != 0 || info.st_size == 0)
+	{
+		::close(file);
+		return false;
+	}
+	void* view = mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+	// the mapping stays valid after closing the descriptor
+	::close(file);
+	if (view == MAP_FAILED) return false;
+	bytes = (const unsigned char*)view;
+	length = (size_t)info.st_size;
+	return true;
+}
+
+void MappedFile::close()
+{
+	if (bytes) munmap((void*)bytes, length);
+	bytes = nullptr;
+	length = 0;
+}
+
+#endif
+
+MappedFile::~MappedFile()
+{
+	close();
+}
+
+// ===================================
+// === platform specific file ops ===
+// ===================================
+
+struct CacheFileInfo
+{
+	std::string path;
+	size_t size;
+	long long lastUse;	// modification time (resolution of the file system)
+};
+
+#ifdef _WIN32
+
+static void createDirectory(const std::string& directory)
+{
+	CreateDirectoryA(directory.c_str(), nullptr);
+}
+
+// rename which replaces an existing target
+static bool replaceFile(const std::string& from, const std::string& to)
+{
+	return MoveFileExA(from.c_str(), to.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+}
+
+static void touchFile(const std::string& path)
+{
+	HANDLE file = CreateFileA(path.c_str(), FILE_WRITE_ATTRIBUTES, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE) return;
+	FILETIME now;
+	GetSystemTimeAsFileTime(&now);
+	SetFileTime(file, nullptr, nullptr, &now);
+	CloseHandle(file);
+}
+
+static unsigned long processId()
+{
+	return (unsigned long)GetCurrentProcessId();
+}
+
+static std::vector<CacheFileInfo> listCacheFiles(const std::string& directory)
+{
+	std::vector<CacheFileInfo> files;
+	WIN32_FIND_DATAA data;
+	HANDLE find = FindFirstFileA((directory + "/*" + BLOB_EXTENSION).c_str(), &data);
+	if (find == INVALID_HANDLE_VALUE) return files;
+	do
+	{
+		CacheFileInfo info;
+		info.path = directory + "/" + data.cFileName;
+		info.size = (size_t)(((unsigned long long)data.nFileSizeHigh << 32) | data.nFileSizeLow);
+		info.lastUse = (long long)(((unsigned long long)data.ftLastWriteTime.dwHighDateTime << 32) | data.ftLastWriteTime.dwLowDateTime);
+		files.push_back(info);
+	} while (FindNextFileA(find, &data));
+	FindClose(find);
+	return files;
+}
+
+#else
+
+static void createDirectory(const std::string& directory)
+{
+	mkdir(directory.c_str(), 0755);
+}
+
+// rename which replaces an existing target
+static bool replaceFile(const std::string& from, const std::string& to)
+{
+	return rename(from.c_str(), to.c_str()) == 0;
+}
+
+static void touchFile(const std::string& path)
+{
+	utimes(path.c_str(), nullptr);
+}
+
+static unsigned long processId()
+{
+	return (unsigned long)getpid();
+}
+
+static std::vector<CacheFileInfo> listCacheFiles(const std::string& directory)
+{
+	std::vector<CacheFileInfo> files;
+	DIR* dir = opendir(directory.c_str());
+	if (!dir) return files;
+	const size_t extensionLength = strlen(BLOB_EXTENSION);
+	while (dirent* entry = readdir(dir))
+	{
+		std::string name = entry->d_name;
+		if (name.size() <= extensionLength || name.compare(name.size() - extensionLength, extensionLength, BLOB_EXTENSION) != 0) continue;
+		CacheFileInfo info;
+		info.path = directory + "/" + name;
+		struct stat status;
+		if (stat(info.path.c_str(), &status) != 0) continue;
+		info.size = (size_t)status.st_size;
+#ifdef __APPLE__
+		info.lastUse = (long long)status.st_mtimespec.tv_sec * 1000000000ll + status.st_mtimespec.tv_nsec;
+#else
+		info.lastUse = (long long)status.st_mtim.tv_sec * 1000000000ll + status.st_mtim.tv_nsec;
+#endif
+		files.push_back(info);
+	}
+	closedir(dir);
+	return files;
+}
+
+#endif
+
+// =============================
+// === TessellationDiskCache ===
+// =============================
+
+TessellationDiskCache::TessellationDiskCache(const std::string& directory_, const size_t sizeCap_ /*= 512 * 1024 * 1024*/) : directory(directory_), sizeCap(sizeCap_)
+{
+	stats.hits = stats.misses = stats.writes = stats.removals = 0;
+	createDirectory(directory);
+}
+
+std::string TessellationDiskCache::entryPath(const TessellationKey key) const
+{
+	char name[64];
+	snprintf(name, sizeof(name), "/%016llx_v%u", key, TESSELLATION_EVALUATOR_VERSION);
+	return directory + name + BLOB_EXTENSION;
+}
+
+bool TessellationDiskCache::load(const TessellationKey key, TessellationResult& result)
+{
+	const std::string path = entryPath(key);
+	MappedFile file;
+	bool valid = file.open(path) && file.size() >= sizeof(BlobHeader);
+	BlobHeader header;
+	size_t numPoints = 0;
+	if (valid)
+	{
+		memcpy(&header, file.data(), sizeof(BlobHeader));
+		numPoints = (size_t)(header.numPointsU * header.numPointsV);
+		const size_t numGridVertices = header.numVertices > 0 ? numPoints : 0;
+		size_t expected = sizeof(BlobHeader) + numPoints * 2 * sizeof(Vec3f) + (header.numPointsU + header.numPointsV + 4 * header.numCurvatures) * sizeof(float)
+			+ header.numVertices * 2 * sizeof(Vec3f) + (header.numIndices + numGridVertices + header.numVertices) * sizeof(unsigned int);
+		valid = memcmp(header.magic, BLOB_MAGIC, sizeof(BLOB_MAGIC)) == 0 && header.evaluatorVersion == TESSELLATION_EVALUATOR_VERSION && header.key == key
+			&& (header.numCurvatures == 0 || header.numCurvatures == numPoints) && file.size() == expected;
+	}
+	std::lock_guard<std::mutex> lock(mutex);
+	if (!valid)
+	{
+		stats.misses++;
+		return false;
+	}
+	stats.hits++;
+
+	// the arrays are stored in memory layout, every buffer is a single copy out of the mapping
+	const unsigned char* data = file.data() + sizeof(BlobHeader);
+	auto copyOut = [&data](void* target, const size_t size)
+	{
+		if (size > 0) memcpy(target, data, size);
+		data += size;
+	};
+	result.mesh.numPointsU = (size_t)header.numPointsU;
+	result.mesh.numPointsV = (size_t)header.numPointsV;
+	result.mesh.points.resize(numPoints);
+	result.mesh.normals.resize(numPoints);
+	result.parametersU.resize(result.mesh.numPointsU);
+	result.parametersV.resize(result.mesh.numPointsV);
+	copyOut(result.mesh.points.data(), numPoints * sizeof(Vec3f));
+	copyOut(result.mesh.normals.data(), numPoints * sizeof(Vec3f));
+	copyOut(result.parametersU.data(), result.parametersU.size() * sizeof(float));
+	copyOut(result.parametersV.data(), result.parametersV.size() * sizeof(float));
+	std::vector<float>* maps[4] = { &result.curvatureMaps.gaussian, &result.curvatureMaps.mean, &result.curvatureMaps.maxPrincipal, &result.curvatureMaps.minPrincipal };
+	for (std::vector<float>* map : maps)
+	{
+		map->resize((size_t)header.numCurvatures);
+		copyOut(map->data(), map->size() * sizeof(float));
+	}
+	IndexedMesh& indexed = result.indexedMesh;
+	indexed.points.resize((size_t)header.numVertices);
+	indexed.normals.resize((size_t)header.numVertices);
+	indexed.indices.resize((size_t)header.numIndices);
+	indexed.gridVertices.resize(header.numVertices > 0 ? numPoints : 0);
+	indexed.vertexSamples.resize((size_t)header.numVertices);
+	copyOut(indexed.points.data(), indexed.points.size() * sizeof(Vec3f));
+	copyOut(indexed.normals.data(), indexed.normals.size() * sizeof(Vec3f));
+	copyOut(indexed.indices.data(), indexed.indices.size() * sizeof(unsigned int));
+	copyOut(indexed.gridVertices.data(), indexed.gridVertices.size() * sizeof(unsigned int));
+	copyOut(indexed.vertexSamples.data(), indexed.vertexSamples.size() * sizeof(unsigned int));
+	indexed.gridACMR = header.gridACMR;
+	indexed.optimizedACMR = header.optimizedACMR;
+	result.milliseconds = header.milliseconds;
+	result.level = 0;
+	result.numLevels = 1;
+	// mark the entry as recently used for the size cleanup
+	touchFile(path);
+	return true;
+}
+
+bool TessellationDiskCache::store(const TessellationKey key, const TessellationResult& result)
+{
+	const size_t numPoints = result.mesh.points.size();
+	const CurvatureMaps& maps = result.curvatureMaps;
+	const bool withCurvatures = maps.gaussian.size() == numPoints && maps.mean.size() == numPoints && maps.maxPrincipal.size() == numPoints && maps.minPrincipal.size() == numPoints;
+	if (result.mesh.normals.size() != numPoints || result.parametersU.size() * result.parametersV.size() != numPoints) return false;
+	const IndexedMesh& indexed = result.indexedMesh;
+	const bool withIndexedMesh = !indexed.points.empty() && indexed.normals.size() == indexed.points.size() && indexed.vertexSamples.size() == indexed.points.size()
+		&& indexed.gridVertices.size() == numPoints;
+
+	BlobHeader header;
+	memset(&header, 0, sizeof(BlobHeader));
+	memcpy(header.magic, BLOB_MAGIC, sizeof(BLOB_MAGIC));
+	header.evaluatorVersion = TESSELLATION_EVALUATOR_VERSION;
+	header.key = key;
+	header.numPointsU = result.mesh.numPointsU;
+	header.numPointsV = result.mesh.numPointsV;
+	header.numCurvatures = withCurvatures ? numPoints : 0;
+	header.milliseconds = result.milliseconds;
+	header.numVertices = withIndexedMesh ? indexed.points.size() : 0;
+	header.numIndices = withIndexedMesh ? indexed.indices.size() : 0;
+	header.gridACMR = indexed.gridACMR;
+	header.optimizedACMR = indexed.optimizedACMR;
+
+	// write into a file of this process and move it into place, readers see either no entry or the whole one
+	const std::string path = entryPath(key);
+	char suffix[32];
+	snprintf(suffix, sizeof(suffix), ".tmp%lu", processId());
+	const std::string temporaryPath = path + suffix;
+	FILE* file = fopen(temporaryPath.c_str(), "wb");
+	if (!file) return false;
+	bool ok = fwrite(&header, sizeof(BlobHeader), 1, file) == 1;
+	auto write = [&](const void* data, const size_t size)
+	{
+		if (ok && size > 0) ok = fwrite(data, 1, size, file) == size;
+	};
+	write(result.mesh.points.data(), numPoints * sizeof(Vec3f));
+	write(result.mesh.normals.data(), numPoints * sizeof(Vec3f));
+	write(result.parametersU.data(), result.parametersU.size() * sizeof(float));
+	write(result.parametersV.data(), result.parametersV.size() * sizeof(float));
+	if (withCurvatures)
+	{
+		write(maps.gaussian.data(), numPoints * sizeof(float));
+		write(maps.mean.data(), numPoints * sizeof(float));
+		write(maps.maxPrincipal.data(), numPoints * sizeof(float));
+		write(maps.minPrincipal.data(), numPoints * sizeof(float));
+	}
+	if (withIndexedMesh)
+	{
+		write(indexed.points.data(), indexed.points.size() * sizeof(Vec3f));
+		write(indexed.normals.data(), indexed.normals.size() * sizeof(Vec3f));
+		write(indexed.indices.data(), indexed.indices.size() * sizeof(unsigned int));
+		write(indexed.gridVertices.data(), indexed.gridVertices.size() * sizeof(unsigned int));
+		write(indexed.vertexSamples.data(), indexed.vertexSamples.size() * sizeof(unsigned int));
+	}
+	ok = (fclose(file) == 0) && ok;
+	if (!ok || !replaceFile(temporaryPath, path))
+	{
+		remove(temporaryPath.c_str());
+		return false;
+	}
+
+	std::lock_guard<std::mutex> lock(mutex);
+	stats.writes++;
+	enforceSizeCap();
+	return true;
+}
+
+TessellationDiskCacheStatistics TessellationDiskCache::statistics() const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return stats;
+}
+
+void TessellationDiskCache::enforceSizeCap()
+{
+	std::vector<CacheFileInfo> files = listCacheFiles(directory);
+	size_t total = 0;
+	for (const CacheFileInfo& file : files) total += file.size;
+	if (total <= sizeCap) return;
+	// oldest first
+	std::sort(files.begin(), files.end(), [](const CacheFileInfo& a, const CacheFileInfo& b) { return a.lastUse < b.lastUse; });
+	for (const CacheFileInfo& file : files)
+	{
+		if (total <= sizeCap) break;
+		if (remove(file.path.c_str()) == 0)
+		{
+			total -= file.size;
+			stats.removals++;
+		}
+	}
+}
@@ -0,0 +1,90 @@
+#ifndef TESSELLATION_DISK_CACHE_H
+#define TESSELLATION_DISK_CACHE_H
+
+#include <stdlib.h>			// standard library
+#include <mutex>			// std::mutex
+#include <string>			// std::string
+
+#include "AsyncTessellation.h"
+#include "TessellationCache.h"
+
+// version of the evaluation code. bump it whenever the tessellation results change,
+// entries written by another version are ignored (and removed by the size cleanup eventually).
+const unsigned int TESSELLATION_EVALUATOR_VERSION = 7;
+
+// read-only memory mapping of a whole file
+class MappedFile
+{
+
+public:
+
+	MappedFile();
+
+	// unmaps the file
+	~MappedFile();
+
+	// map filename, returns false if it does not exist or can not be mapped
+	bool open(const std::string& filename);
+
+	void close();
+
+	const unsigned char* data() const { return bytes; }
+	size_t size() const { return length; }
+
+private:
+
+	MappedFile(const MappedFile&);
+	MappedFile& operator=(const MappedFile&);
+
+	const unsigned char* bytes;
+	size_t length;
+#ifdef _WIN32
+	void* fileHandle;
+	void* mappingHandle;
+#endif
+
+};
+
+struct TessellationDiskCacheStatistics
+{
+	size_t hits;
+	size_t misses;
+	size_t writes;
+	size_t removals;	// files deleted by the size cleanup
+};
+
+// persistent cache of finished tessellations, one file per content hash in a directory.
+// files are read through a memory mapping and written to a temporary file which is renamed into place,
+// so concurrent readers never see a partial file. when the directory exceeds the size cap after a write,
+// the least recently used files are removed (loading a file updates its modification time).
+class TessellationDiskCache
+{
+
+public:
+
+	TessellationDiskCache(const std::string& directory_, const size_t sizeCap_ = 512 * 1024 * 1024);
+
+	// load the result of key. returns false if there is no valid entry of the current evaluator version.
+	bool load(const TessellationKey key, TessellationResult& result);
+
+	// store the result of key, returns false if the file could not be written
+	bool store(const TessellationKey key, const TessellationResult& result);
+
+	TessellationDiskCacheStatistics statistics() const;
+
+private:
+
+	// path of the entry of key
+	std::string entryPath(const TessellationKey key) const;
+
+	// remove least recently used entries until the directory is below the size cap
+	void enforceSizeCap();
+
+	std::string directory;
+	size_t sizeCap;
+	mutable std::mutex mutex;
+	TessellationDiskCacheStatistics stats;
+
+};
+
+#endif // TESSELLATION_DISK_CACHE_H
@@ -19,6 +19,7 @@
 // Right sided float: /                                                      //
 // Functions: length(), sqlength(), distance(Vec3 v), normalize(),           //
 //            normalized(), clear(), set(f,f,f), rotations                   //
+// Free functions: T * Vec3, lerp(a, b, alpha)                               //
 // ========================================================================= //
 
 #ifndef VEC3_H
@@ -26,6 +27,7 @@
 
 #include <math.h>
 #include <string>
+#include <type_traits>
 
 #define M_RadToDeg 0.0174532925f
 
@@ -50,10 +52,9 @@ public:
   {
   }
 
-  // copy constuctor
-  Vec3(const Vec3 & other) : x(other.x), y(other.y), z(other.z)
-  {
-  }
+  // copy constructor and assignment are the implicit ones, so Vec3 is trivially copyable (memcpy, std::vector growth)
+  Vec3(const Vec3 & other) = default;
+  Vec3 & operator= (const Vec3 & other) = default;
 
   // returns i-th komponent (i=0,1,2) (RHS array operator)
   const T operator[] (unsigned int i) const
@@ -70,21 +71,13 @@ public:
   // Vec3 = Vec3 + Vec3 (vector addition)
   Vec3 operator+ (const Vec3 &v) const
   {
-    Vec3 result;
-    result.x = x + v.x;
-    result.y = y + v.y;
-    result.z = z + v.z;
-    return result;
+    return Vec3(x + v.x, y + v.y, z + v.z);
   }
 
   // Vec3 = Vec3 - Vec3 (normal vector subtraction)
   Vec3 operator- (const Vec3 &v) const
   {
-    Vec3 result;
-    result.x = x - v.x;
-    result.y = y - v.y;
-    result.z = z - v.z;
-    return result;
+    return Vec3(x - v.x, y - v.y, z - v.z);
   }
 
   // T = Vec3 * Vec3 (dot product)
@@ -96,38 +89,42 @@ public:
   // Vec3 = Vec3 ^ Vec3 (cross product)
   Vec3 operator^ (const Vec3 &v) const
   {
-    Vec3 result;
-    result.x = y*v.z - z*v.y;
-    result.y = z*v.x - x*v.z;
-    result.z = x*v.y - y*v.x;
-    return result;
+    return Vec3(y*v.z - z*v.y, z*v.x - x*v.z, x*v.y - y*v.x);
   }
 
   // Vec3 += Vec3 (vector addition)
-  Vec3 operator+= (const Vec3 &v)
+  Vec3 & operator+= (const Vec3 &v)
   {
-    *this = *this + v;
+    x += v.x;
+    y += v.y;
+    z += v.z;
     return *this;
   }
 
   // Vec3 -= Vec3 (vector subtraction)
-  Vec3 operator-= (const Vec3 &v)
+  Vec3 & operator-= (const Vec3 &v)
   {
-    *this = *this - v;
+    x -= v.x;
+    y -= v.y;
+    z -= v.z;
     return *this;
   }
 
   // Vec3 *= T (scalar multiplication)
-  Vec3 operator*= (const T f)
+  Vec3 & operator*= (const T f)
   {
-    *this = *this * f;
+    x *= f;
+    y *= f;
+    z *= f;
     return *this;
   }
 
   // Vec3 /= T (scalar division)
-  Vec3 operator/= (const T f)
+  Vec3 & operator/= (const T f)
   {
-    *this = *this / f;
+    x /= f;
+    y /= f;
+    z /= f;
     return *this;
   }
 
@@ -147,21 +144,13 @@ public:
   // Vec3 = Vec3 * T (scalar multiplication)
   Vec3 operator* (const T &f) const
   {
-    Vec3 result;
-    result.x = x * f;
-    result.y = y * f;
-    result.z = z * f;
-    return result;
+    return Vec3(x * f, y * f, z * f);
   }
 
   // Vec3 = Vec3 / T (scalar division)
   Vec3 operator/ (const T &f) const
   {
-    Vec3 result;
-    result.x = x / f;
-    result.y = y / f;
-    result.z = z / f;
-    return result;
+    return Vec3(x / f, y / f, z / f);
   }
 
   // returns euclidic length (sqrt(x*x + y*y + z*z))
@@ -258,6 +247,13 @@ Vec3<T> operator* (const T &f, const Vec3<T> &v)
   return v * f;
 }
 
+// Vec3 = a + alpha * (b - a) (linear blend, a for alpha = 0 and b for alpha = 1)
+template <class T>
+Vec3<T> lerp(const Vec3<T> &a, const Vec3<T> &b, const T alpha)
+{
+  return Vec3<T>(a.x + alpha * (b.x - a.x), a.y + alpha * (b.y - a.y), a.z + alpha * (b.z - a.z));
+}
+
 // ostream << operator
 template< class T>
 std::ostream& operator<< (std::ostream& os, const Vec3<T> & v)
@@ -272,6 +268,8 @@ typedef Vec3<int>           Vec3i;
 typedef Vec3<unsigned int>  Vec3ui;
 typedef Vec3<double>        Vec3d;
 
+static_assert(std::is_trivially_copyable<Vec3f>::value && sizeof(Vec3f) == 3 * sizeof(float), "Vec3f has to stay a plain block of 3 floats");
+
 //} // namespace std
 
 #endif
\ No newline at end of file
@@ -15,12 +15,119 @@
 
 #include <math.h>
 #include <string>
+#include <type_traits>
+
+// the arithmetic of Vec4<float> runs on SSE registers on x86 and NEON registers on ARM. define VEC4_NO_SIMD (cmake option
+// ENABLE_VEC4_SIMD=OFF) for the plain C++ version.
+#if !defined(VEC4_NO_SIMD) && (defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1))
+#define VEC4_SSE
+#include <immintrin.h>
+#elif !defined(VEC4_NO_SIMD) && (defined(__ARM_NEON) || defined(__ARM_NEON__))
+#define VEC4_NEON
+#include <arm_neon.h>
+#endif
 
 // embed in namespace std to not mix up with OpenSG Vec4 or any others
 //namespace std {
 
+// component-wise arithmetic on the 4 values at a and b, written to r (which may be a or b)
 template<class T>
-class Vec4
+struct Vec4Arithmetic
+{
+	static void add(const T* a, const T* b, T* r)
+	{
+		for (int i = 0; i < 4; i++) r[i] = a[i] + b[i];
+	}
+
+	static void subtract(const T* a, const T* b, T* r)
+	{
+		for (int i = 0; i < 4; i++) r[i] = a[i] - b[i];
+	}
+
+	static void multiply(const T* a, const T f, T* r)
+	{
+		for (int i = 0; i < 4; i++) r[i] = a[i] * f;
+	}
+
+	static void divide(const T* a, const T f, T* r)
+	{
+		for (int i = 0; i < 4; i++) r[i] = a[i] / f;
+	}
+
+	// r = a + alpha * (b - a)
+	static void lerp(const T* a, const T* b, const T alpha, T* r)
+	{
+		for (int i = 0; i < 4; i++) r[i] = a[i] + alpha * (b[i] - a[i]);
+	}
+
+	// r = a * f + b
+	static void multiplyAdd(const T* a, const T f, const T* b, T* r)
+	{
+		for (int i = 0; i < 4; i++) r[i] = a[i] * f + b[i];
+	}
+};
+
+#if defined(VEC4_SSE)
+// unaligned loads and stores: std::vector does not guarantee the alignment of Vec4 before C++17
+template<>
+struct Vec4Arithmetic<float>
+{
+	static void add(const float* a, const float* b, float* r) { _mm_storeu_ps(r, _mm_add_ps(_mm_loadu_ps(a), _mm_loadu_ps(b))); }
+	static void subtract(const float* a, const float* b, float* r) { _mm_storeu_ps(r, _mm_sub_ps(_mm_loadu_ps(a), _mm_loadu_ps(b))); }
+	static void multiply(const float* a, const float f, float* r) { _mm_storeu_ps(r, _mm_mul_ps(_mm_loadu_ps(a), _mm_set1_ps(f))); }
+	static void divide(const float* a, const float f, float* r) { _mm_storeu_ps(r, _mm_div_ps(_mm_loadu_ps(a), _mm_set1_ps(f))); }
+	static void lerp(const float* a, const float* b, const float alpha, float* r)
+	{
+		const __m128 va = _mm_loadu_ps(a);
+#ifdef __FMA__
+		_mm_storeu_ps(r, _mm_fmadd_ps(_mm_set1_ps(alpha), _mm_sub_ps(_mm_loadu_ps(b), va), va));
+#else
+		_mm_storeu_ps(r, _mm_add_ps(va, _mm_mul_ps(_mm_set1_ps(alpha), _mm_sub_ps(_mm_loadu_ps(b), va))));
+#endif
+	}
+	static void multiplyAdd(const float* a, const float f, const float* b, float* r)
+	{
+#ifdef __FMA__
+		_mm_storeu_ps(r, _mm_fmadd_ps(_mm_loadu_ps(a), _mm_set1_ps(f), _mm_loadu_ps(b)));
+#else
+		_mm_storeu_ps(r, _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(a), _mm_set1_ps(f)), _mm_loadu_ps(b)));
+#endif
+	}
+};
+#elif defined(VEC4_NEON)
+template<>
+struct Vec4Arithmetic<float>
+{
+	static void add(const float* a, const float* b, float* r) { vst1q_f32(r, vaddq_f32(vld1q_f32(a), vld1q_f32(b))); }
+	static void subtract(const float* a, const float* b, float* r) { vst1q_f32(r, vsubq_f32(vld1q_f32(a), vld1q_f32(b))); }
+	static void multiply(const float* a, const float f, float* r) { vst1q_f32(r, vmulq_n_f32(vld1q_f32(a), f)); }
+	static void divide(const float* a, const float f, float* r)
+	{
+		// no vector division on 32 bit ARM
+		for (int i = 0; i < 4; i++) r[i] = a[i] / f;
+	}
+	static void lerp(const float* a, const float* b, const float alpha, float* r)
+	{
+		const float32x4_t va = vld1q_f32(a);
+#if defined(__aarch64__)
+		vst1q_f32(r, vfmaq_n_f32(va, vsubq_f32(vld1q_f32(b), va), alpha));
+#else
+		vst1q_f32(r, vmlaq_n_f32(va, vsubq_f32(vld1q_f32(b), va), alpha));
+#endif
+	}
+	static void multiplyAdd(const float* a, const float f, const float* b, float* r)
+	{
+#if defined(__aarch64__)
+		vst1q_f32(r, vfmaq_n_f32(vld1q_f32(b), vld1q_f32(a), f));
+#else
+		vst1q_f32(r, vmlaq_n_f32(vld1q_f32(b), vld1q_f32(a), f));
+#endif
+	}
+};
+#endif
+
+template<class T>
+class alignas(16) Vec4
 {
 public:
 
@@ -37,10 +144,9 @@ public:
 	{
 	}
 
-	// copy constuctor
-	Vec4(const Vec4 & other) : x(other.x), y(other.y), z(other.z), w(other.w)
-	{
-	}
+	// copy constructor and assignment are the implicit ones, so Vec4 is trivially copyable (memcpy, std::vector growth)
+	Vec4(const Vec4 & other) = default;
+	Vec4 & operator= (const Vec4 & other) = default;
 
 	// returns i-th komponent (i=0,1,2,3) (RHS array operator)
 	const T operator[] (unsigned int i) const
@@ -57,22 +163,16 @@ public:
 	// Vec4 = Vec4 + Vec4 (vector addition)
 	Vec4 operator+ (const Vec4 &v) const
 	{
-		Vec4 result;
-		result.x = x + v.x;
-		result.y = y + v.y;
-		result.z = z + v.z;
-		result.w = w + v.w;
+		Vec4 result(*this);
+		result += v;
 		return result;
 	}
 
 	// Vec4 = Vec4 - Vec4 (normal vector subtraction)
 	Vec4 operator- (const Vec4 &v) const
 	{
-		Vec4 result;
-		result.x = x - v.x;
-		result.y = y - v.y;
-		result.z = z - v.z;
-		result.w = w - v.w;
+		Vec4 result(*this);
+		result -= v;
 		return result;
 	}
 
@@ -85,50 +185,44 @@ public:
 	// Vec4 = Vec4 * T (scalar multiplication)
 	Vec4 operator* (const T &f) const
 	{
-		Vec4 result;
-		result.x = x * f;
-		result.y = y * f;
-		result.z = z * f;
-		result.w = w * f;
+		Vec4 result(*this);
+		result *= f;
 		return result;
 	}
 
 	// Vec4 = Vec4 / T (scalar division)
 	Vec4 operator/ (const T &f) const
 	{
-		Vec4 result;
-		result.x = x / f;
-		result.y = y / f;
-		result.z = z / f;
-		result.w = w / f;
+		Vec4 result(*this);
+		result /= f;
 		return result;
 	}
 
 	// Vec4 += Vec4 (vector addition)
-	Vec4 operator+= (const Vec4 &v)
+	Vec4 & operator+= (const Vec4 &v)
 	{
-		*this = *this + v;
+		Vec4Arithmetic<T>::add(&x, &v.x, &x);
 		return *this;
 	}
 
 	// Vec4 -= Vec4 (vector subtraction)
-	Vec4 operator-= (const Vec4 &v)
+	Vec4 & operator-= (const Vec4 &v)
 	{
-		*this = *this - v;
+		Vec4Arithmetic<T>::subtract(&x, &v.x, &x);
 		return *this;
 	}
 
 	// Vec4 *= T (scalar multiplication)
-	Vec4 operator*= (const T f)
+	Vec4 & operator*= (const T f)
 	{
-		*this = *this * f;
+		Vec4Arithmetic<T>::multiply(&x, f, &x);
 		return *this;
 	}
 
 	// Vec4 /= T (scalar division)
-	Vec4 operator/= (const T f)
+	Vec4 & operator/= (const T f)
 	{
-		*this = *this / f;
+		Vec4Arithmetic<T>::divide(&x, f, &x);
 		return *this;
 	}
 
@@ -232,6 +326,25 @@ Vec4<T> operator* (const T &f, const Vec4<T> &v)
 	return v * f;
 }
 
+// Vec4 = a + alpha * (b - a) (linear blend, a for alpha = 0 and b for alpha = 1). one subtraction and one multiply-add per
+// component, fused where the target supports it.
+template <class T>
+Vec4<T> lerp(const Vec4<T> &a, const Vec4<T> &b, const T alpha)
+{
+	Vec4<T> result(a);
+	Vec4Arithmetic<T>::lerp(&a.x, &b.x, alpha, &result.x);
+	return result;
+}
+
+// Vec4 = a * f + b (one multiply-add per component, fused where the target supports it)
+template <class T>
+Vec4<T> multiplyAdd(const Vec4<T> &a, const T f, const Vec4<T> &b)
+{
+	Vec4<T> result(b);
+	Vec4Arithmetic<T>::multiplyAdd(&a.x, f, &b.x, &result.x);
+	return result;
+}
+
 // ostream << operator
 template< class T>
 std::ostream& operator<< (std::ostream& os, const Vec4<T> & v)
@@ -246,6 +359,8 @@ typedef Vec4<int>           Vec4i;
 typedef Vec4<unsigned int>  Vec4ui;
 typedef Vec4<double>        Vec4d;
 
+static_assert(std::is_trivially_copyable<Vec4f>::value && sizeof(Vec4f) == 4 * sizeof(float), "Vec4f has to stay a plain block of 4 floats");
+
 //} // namespace std
 
 #endif
\ No newline at end of file
@@ -18,7 +18,17 @@
 #include <cmath>		// fmod
 #include <stdio.h>		// cout
 #include <iostream>		// cout
+#include <memory>		// std::unique_ptr
+#include <chrono>		// benchmark timing
+#include <algorithm>	// std::min
+#include <thread>		// std::thread
 #include "RenderingSurface.h"
+#include "RenderingCurve.h"
+#include "Profiler.h"
+#include "NURBS_PowerBasis.h"
+#include "NURBS_Projection.h"
+#include "NURBS_CurveSet.h"
+#include "ConcurrencyStress.h"
 
 // ==============
 // === BASICS ===
@@ -270,56 +280,131 @@ void createNURBSs() {
 
 void calculatePoints()
 {
+	PROFILE_SCOPE("calculatePoints");
 	// TODO: create two NURBS surfaces with different degrees k >= 2
 	// calculate the points and their normals
 	// emplace the resulting NURBS, points and normals into the vectors
 	// =====================================================
 	
-	points.clear();
-	normals.clear();
-	numPointsU = 0;
-	numPointsV = 0;
-	NURBS_Surface nurbs = NURBSs.at(nurbsSelect);
-
-	std::cout << std::endl << nurbs << "Calculating ";
+	NURBS_Surface& nurbs = NURBSs.at(nurbsSelect);
+
+	// a recently viewed surface comes from the memory cache, a surface of an earlier run from the disk cache
+	const float resU = resolutionU.at(nurbsSelect);
+	const float resV = resolutionV.at(nurbsSelect);
+	pendingTessellationKey = tessellationKey(nurbs, resU, resV, tessellationMode);
+	std::shared_ptr<const TessellationResult> cached = findCachedTessellation(pendingTessellationKey);
+	if (cached)
+	{
+		tessellator.cancel();
+		applyTessellation(cached);
+		TessellationCacheStatistics stats = tessellationCache.statistics();
+		TessellationDiskCacheStatistics diskStats = tessellationDiskCache.statistics();
+		std::cout << std::endl << nurbs << "Tessellation (" << tessellationModeName(tessellationMode) << ") from cache (memory: " << stats.hits << " hits, " << stats.misses << " misses, disk: " << diskStats.hits << " hits)" << std::endl;
+		coutIndexedMesh();
+		glutPostRedisplay();
+		return;
+	}
 
-	size_t triggerpoints = ((1 / resolutionU.at(nurbsSelect)) * (1 / resolutionV.at(nurbsSelect))) / 25 ;
-	size_t currnumpoints = 0;
+	std::cout << std::endl << nurbs << "Calculating (" << tessellationModeName(tessellationMode) << ") in the background" << std::endl;
 
-	for (float u = 0; u <= 1.0f; u += resolutionU.at(nurbsSelect))
+	// the job publishes a coarse preview first and refines it, the current mesh is drawn until a level is ready.
+	// a job which is still running for the previous surface is cancelled.
+	tessellator.start(nurbs, nurbsSelect, resU, resV, tessellationMode);
+	if (!tessellationPolling)
 	{
-		numPointsU++;
-		numPointsV = 0;
-
-		std::vector<Vec4f> temppoints;
-		for (float v = 0; v <= 1.0f; v += resolutionV.at(nurbsSelect))
-		{
-			numPointsV++;
-			Vec4f tangentU;
-			Vec4f tangentV;
-			points.push_back(nurbs.evaluteDeBoor(u, v, tangentU, tangentV));
-
-			// the crossproduct
-			Vec4f tu = tangentU.homogenized();
-			Vec4f tv = tangentV.homogenized();
-
-			Vec3f normal = Vec3f(tu.y * tv.z - tu.z * tv.y, tu.z * tv.x - tu.x * tv.z, tu.x * tv.y - tu.y * tv.x);
-			normals.push_back(normal);
-			currnumpoints++;
-			if (currnumpoints % triggerpoints == 0) std::cout << ".";
-		}
+		tessellationPolling = true;
+		glutTimerFunc(TESSELLATION_POLL_MS, pollTessellation, 0);
 	}
-	std::cout << " Done !" << std::endl;
 	// =====================================================
 	
 }
 
+void pollTessellation(int /*value*/)
+{
+	std::shared_ptr<const TessellationResult> result;
+	if (tessellator.takeResult(result))
+	{
+		applyTessellation(result);
+		std::cout << "Level " << result->level + 1 << "/" << result->numLevels << ": " << result->mesh.numPointsU << " x " << result->mesh.numPointsV << " samples in " << result->milliseconds << " ms" << (result->level + 1 == result->numLevels ? " Done !" : "") << std::endl;
+		if (result->level + 1 == result->numLevels) coutIndexedMesh();
+		// only the final level is cached
+		if (result->level + 1 == result->numLevels && !result->mesh.points.empty())
+			cacheTessellation(pendingTessellationKey, result);
+		glutPostRedisplay();
+	}
+	// keep polling while the job is running
+	tessellationPolling = tessellator.isBusy();
+	if (tessellationPolling) glutTimerFunc(TESSELLATION_POLL_MS, pollTessellation, 0);
+}
+
+void applyTessellation(const std::shared_ptr<const TessellationResult>& result)
+{
+	// the result is shared with the cache, not copied
+	meshPublisher.publish(makeMeshSnapshot(result, curvatureDisplay));
+	tessellationMilliseconds = result->milliseconds;
+	tessellationSamples = result->mesh.points.size();
+	PROFILE_COUNTER("tessellation samples", result->mesh.points.size());
+}
+
+void updateCurvatureColors()
+{
+	std::shared_ptr<const MeshSnapshot> snapshot = meshPublisher.current();
+	if (snapshot) meshPublisher.publish(makeMeshSnapshot(snapshot->tessellation, curvatureDisplay));
+}
+
+std::shared_ptr<const TessellationResult> findCachedTessellation(const TessellationKey key)
+{
+	std::shared_ptr<const TessellationResult> cached = tessellationCache.find(key);
+	if (cached) return cached;
+	std::shared_ptr<TessellationResult> loaded(new TessellationResult());
+	if (!tessellationDiskCache.load(key, *loaded)) return nullptr;
+	tessellationCache.insert(key, loaded);
+	return loaded;
+}
+
+void cacheTessellation(const TessellationKey key, const std::shared_ptr<const TessellationResult>& result)
+{
+	tessellationDiskCache.store(key, *result);
+	tessellationCache.insert(key, result);
+}
+
+void calculateScene()
+{
+	PROFILE_SCOPE("calculateScene");
+	auto start = std::chrono::high_resolution_clock::now();
+	// take what is cached, tessellate the rest in one batch
+	sceneMeshes.assign(NURBSs.size(), nullptr);
+	std::vector<TessellationKey> keys(NURBSs.size());
+	std::vector<SceneSurface> missing;
+	std::vector<size_t> missingIndices;
+	for (size_t i = 0; i < NURBSs.size(); i++)
+	{
+		keys[i] = tessellationKey(NURBSs[i], resolutionU.at(i), resolutionV.at(i), tessellationMode);
+		sceneMeshes[i] = findCachedTessellation(keys[i]);
+		if (sceneMeshes[i]) continue;
+		missing.push_back(SceneSurface(&NURBSs[i], resolutionU.at(i), resolutionV.at(i)));
+		missingIndices.push_back(i);
+	}
+	std::vector<std::shared_ptr<TessellationResult>> results;
+	size_t numJobs = tessellateScene(missing, tessellationMode, JobScheduler::global(), results);
+	for (size_t m = 0; m < missing.size(); m++)
+	{
+		if (!results[m]) continue;
+		results[m]->surfaceIndex = missingIndices[m];
+		sceneMeshes[missingIndices[m]] = results[m];
+		cacheTessellation(keys[missingIndices[m]], results[m]);
+	}
+	double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+	std::cout << "Scene (" << tessellationModeName(tessellationMode) << "): " << NURBSs.size() << " surfaces, " << NURBSs.size() - missing.size() << " cached, "
+		<< missing.size() << " tessellated in " << numJobs << " jobs on " << JobScheduler::global().concurrency() << " threads, " << milliseconds << " ms" << std::endl;
+}
+
 void reshape(GLint width, GLint height)
 {
 	glViewport(0, 0, width, height);
 	glMatrixMode(GL_PROJECTION);
 	glLoadIdentity();
-	gluPerspective(65.0, (float)width / (float)height, 0.1f, 1000);
+	gluPerspective(CAMERA_FIELD_OF_VIEW, (float)width / (float)height, 0.1f, 1000);
 	glMatrixMode(GL_MODELVIEW);
 	glLoadIdentity();
 }
@@ -332,6 +417,7 @@ void drawCS()
 {
 	glDisable(GL_LIGHTING);
 	glBegin(GL_LINES);
+	countDrawCall();
 	// red X
 	glColor3f(1, 0, 0); 
 	glVertex3f(0, 0, 0);
@@ -352,7 +438,31 @@ void drawObjects()
 	if (NURBSs.empty() || nurbsSelect >= NURBSs.size() || nurbsSelect < 0)
 		return;
 
-	NURBS_Surface nurbs = NURBSs.at(nurbsSelect);
+	if (sceneMode)
+	{
+		// all surfaces, the evaluation is only shown on the selected one
+		for (size_t i = 0; i < NURBSs.size() && i < sceneMeshes.size(); i++)
+		{
+			const NURBS_Surface& nurbs = NURBSs[i];
+			const TessellationResult* mesh = sceneMeshes[i].get();
+			if (!mesh || nurbs.controlPoints.size() <= 1) continue;
+			if (enableEval > 0 && i == nurbsSelect)
+				evaluateNURBSSurface(nurbs, u, v, enableEval == 1);
+			if (enableCtrl)
+				drawNURBSSurfaceCtrlP(nurbs);
+			if (enableNormals)
+				drawNormals(mesh->mesh.points, mesh->mesh.normals);
+			if (enableWireframe || enableSurf)
+				drawNURBSSurface(mesh->indexedMesh, mesh->mesh.numPointsU, mesh->mesh.numPointsV, enableSurf, enableWireframe);
+		}
+		return;
+	}
+
+	// a reference, the evaluation visualization caches its curves per surface
+	const NURBS_Surface& nurbs = NURBSs.at(nurbsSelect);
+	// the snapshot of this frame, a newer one published meanwhile is drawn in the next frame
+	std::shared_ptr<const MeshSnapshot> snapshot = meshPublisher.current();
+	const TessellationResult* mesh = snapshot ? snapshot->tessellation.get() : nullptr;
 
 
 	if(nurbs.controlPoints.size() > 1)
@@ -364,17 +474,63 @@ void drawObjects()
 			drawNURBSSurfaceCtrlP(nurbs);
 		// TODO: draw nurbs surface
 		// ========================
-		if(enableNormals)
-			drawNormals(points, normals);
-		if (enableWireframe || enableSurf)
-			drawNURBSSurface(points, normals, numPointsU, numPointsV, enableSurf, enableWireframe);
+		if(enableNormals && mesh)
+			drawNormals(mesh->mesh.points, mesh->mesh.normals);
+		if ((enableWireframe || enableSurf) && mesh)
+			drawNURBSSurface(mesh->indexedMesh, mesh->mesh.numPointsU, mesh->mesh.numPointsV, enableSurf, enableWireframe, snapshot->vertexColors.empty() ? nullptr : &snapshot->vertexColors);
 
 		// ========================
 	}
 }
 
+void drawHUD()
+{
+	float mean, p95, max;
+	frameTimes.summary(mean, p95, max);
+	std::shared_ptr<const MeshSnapshot> snapshot = meshPublisher.current();
+	static const TessellationResult empty;
+	const TessellationResult& current = (snapshot && snapshot->tessellation) ? *snapshot->tessellation : empty;
+	const IndexedMesh& indexedMesh = current.indexedMesh;
+	size_t bufferBytes = (current.mesh.points.capacity() + current.mesh.normals.capacity()) * sizeof(Vec3f);
+	char line[128];
+	std::vector<std::string> lines;
+	snprintf(line, sizeof(line), "frame: mean %.2f ms, p95 %.2f ms, max %.2f ms (%u frames)", mean, p95, max, (unsigned int)frameTimes.size());
+	lines.push_back(line);
+	snprintf(line, sizeof(line), "triangles: %u, draw calls: %u", (unsigned int)renderCounters.triangles, (unsigned int)renderCounters.drawCalls);
+	lines.push_back(line);
+	snprintf(line, sizeof(line), "tessellation (%s): %.1f ms, %.2f M samples/s", tessellationModeName(tessellationMode), tessellationMilliseconds,
+		tessellationMilliseconds > 0.0 ? tessellationSamples / (tessellationMilliseconds * 1000.0) : 0.0);
+	lines.push_back(line);
+	snprintf(line, sizeof(line), "points/normals: %u samples, %.2f MB (snapshot %llu)", (unsigned int)current.mesh.points.size(), bufferBytes / (1024.0 * 1024.0), meshPublisher.epoch());
+	lines.push_back(line);
+	snprintf(line, sizeof(line), "indexed mesh: %u vertices, ACMR %.2f -> %.2f, %.2f MB (unindexed %.2f MB)", (unsigned int)indexedMesh.points.size(),
+		indexedMesh.gridACMR, indexedMesh.optimizedACMR, indexedMeshBytes(indexedMesh) / (1024.0 * 1024.0), unindexedMeshBytes(current.mesh.numPointsU, current.mesh.numPointsV) / (1024.0 * 1024.0));
+	lines.push_back(line);
+	TessellationCacheStatistics cacheStats = tessellationCache.statistics();
+	snprintf(line, sizeof(line), "cache: %u hits, %u misses, %u evictions, %u entries, %.1f / %.0f MB", (unsigned int)cacheStats.hits, (unsigned int)cacheStats.misses,
+		(unsigned int)cacheStats.evictions, (unsigned int)cacheStats.entries, cacheStats.bytes / (1024.0 * 1024.0), cacheStats.byteBudget / (1024.0 * 1024.0));
+	lines.push_back(line);
+	TessellationDiskCacheStatistics diskStats = tessellationDiskCache.statistics();
+	snprintf(line, sizeof(line), "disk cache: %u hits, %u misses, %u writes, %u removed", (unsigned int)diskStats.hits, (unsigned int)diskStats.misses,
+		(unsigned int)diskStats.writes, (unsigned int)diskStats.removals);
+	lines.push_back(line);
+	drawTextOverlay(lines);
+}
+
+void updateCurveSamplingTolerance()
+{
+	// world size of a pixel at the distance of the scene origin from the camera
+	const float distance = std::max(sqrtf(transX * transX + transY * transY + transZ * transZ), 0.1f);
+	const int height = std::max(glutGet(GLUT_WINDOW_HEIGHT), 1);
+	const float pixelSize = 2.0f * distance * (float)tan(0.5 * CAMERA_FIELD_OF_VIEW * M_RadToDeg) / (float)height;
+	setCurveSamplingTolerance(CURVE_PIXEL_TOLERANCE * pixelSize);
+}
+
 void renderScene()
 {
+	PROFILE_SCOPE("renderScene");
+	auto frameStart = std::chrono::high_resolution_clock::now();
+	renderCounters = RenderCounters();
 	// clear and set camera
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 	glLoadIdentity();
@@ -383,12 +539,16 @@ void renderScene()
 	// rotate scene
 	glRotatef(angleX, 0.0f, 1.0f, 0.0f);
 	glRotatef(angleY, 1.0f, 0.0f, 0.0f);
+	updateCurveSamplingTolerance();
 	// draw coordinate system without lighting
 	drawCS();
 	drawObjects();
+	if (enableHUD)
+		drawHUD();
 	// swap Buffers
 	glFlush();
 	glutSwapBuffers();
+	frameTimes.add(std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - frameStart).count());
 }
 
 // =================
@@ -455,6 +615,49 @@ void keyPressed(unsigned char key, int x, int y)
 		glutPostRedisplay();
 		std::cout << "Surface normals: " << (enableSurf ? "enabled" : "disabled") << "\n";
 		break;
+	case 'i':
+	case 'I':
+		enableHUD = !enableHUD;
+		glutPostRedisplay();
+		std::cout << "Statistics overlay: " << (enableHUD ? "enabled" : "disabled") << "\n";
+		break;
+	case 'm':
+	case 'M':
+		sceneMode = !sceneMode;
+		std::cout << "Scene mode (all surfaces): " << (sceneMode ? "enabled" : "disabled") << "\n";
+		if (sceneMode) calculateScene();
+		glutPostRedisplay();
+		break;
+	case 'k':
+	case 'K':
+		curvatureDisplay = CurvatureType((curvatureDisplay + 1) % CURVATURE_TYPE_COUNT);
+		updateCurvatureColors();
+		glutPostRedisplay();
+		std::cout << "Curvature map: " << curvatureName(curvatureDisplay) << "\n";
+		break;
+	case 'f':
+	case 'F':
+		tessellationMode = TessellationMode((tessellationMode + 1) % TESSELLATION_MODE_COUNT);
+		calculatePoints();
+		if (sceneMode) calculateScene();
+		glutPostRedisplay();
+		break;
+	case 'b':
+	case 'B':
+		benchmarkTessellation();
+		break;
+	case 'x':
+	case 'X':
+		stressConcurrentEvaluation();
+		break;
+	case 't':
+	case 'T':
+	{
+		size_t numEvents = writeChromeTrace("trace.json");
+		if (numEvents > 0)	std::cout << "Trace: " << numEvents << " events written to trace.json\n";
+		else				std::cout << "Trace: nothing recorded (build with ENABLE_PROFILING)\n";
+		break;
+	}
 	case '8':
 		u += 0.1f;
 		if (u > 1) u = 1.0f;
@@ -536,9 +739,262 @@ void coutHelp()
 	std::cout << "A: switch between NURBS surfaces" << std::endl;
 	// TODO: update help text according to your changes
 	// ================================================
+	std::cout << "I: toggle statistics overlay ((I)nfo: frame time, triangles, draw calls, tessellation)" << std::endl;
+	std::cout << "M: toggle scene (M)ode: tessellate and draw all surfaces" << std::endl;
+	std::cout << "K: switch (K)urvature map (none, gaussian, mean, max principal, min principal)" << std::endl;
+	std::cout << "F: switch tessellation evaluator (exact de Boor, (F)orward differences, power basis)" << std::endl;
+	std::cout << "B: run tessellation (B)enchmark on the current surface" << std::endl;
+	std::cout << "T: write profiler (T)race to trace.json (chrome://tracing)" << std::endl;
+	std::cout << "X: stress test concurrent evaluation of the current surface" << std::endl;
 
 
 	// ================================================
 	std::cout << "==========================" << std::endl;
 	std::cout << std::endl;
-}
\ No newline at end of file
+}
+
+void coutIndexedMesh()
+{
+	std::shared_ptr<const MeshSnapshot> snapshot = meshPublisher.current();
+	if (!snapshot || !snapshot->tessellation || snapshot->tessellation->indexedMesh.points.empty()) return;
+	const TessellatedMesh& mesh = snapshot->tessellation->mesh;
+	const IndexedMesh& indexedMesh = snapshot->tessellation->indexedMesh;
+	const size_t unindexedBytes = unindexedMeshBytes(mesh.numPointsU, mesh.numPointsV);
+	const size_t indexedBytes = indexedMeshBytes(indexedMesh);
+	std::cout << "Indexed mesh: " << indexedMesh.points.size() << " vertices (" << mesh.points.size() - indexedMesh.points.size() << " samples welded), "
+		<< indexedMesh.indices.size() / 3 << " triangles, ACMR " << indexedMesh.gridACMR << " (grid order) -> " << indexedMesh.optimizedACMR << " (optimized), "
+		<< indexedBytes / 1024 << " KB instead of " << unindexedBytes / 1024 << " KB unindexed" << std::endl;
+}
+
+void benchmarkTessellation()
+{
+	NURBS_Surface& nurbs = NURBSs.at(nurbsSelect);
+	std::vector<float> benchmarkU = gridParameters(resolutionU.at(nurbsSelect));
+	std::vector<float> benchmarkV = gridParameters(resolutionV.at(nurbsSelect));
+	const size_t numSamples = benchmarkU.size() * benchmarkV.size();
+	std::cout << std::endl << "Tessellation benchmark (" << benchmarkU.size() << " x " << benchmarkV.size() << " samples)" << std::endl;
+	// convert to power basis outside the timed tessellation
+	auto conversionStart = std::chrono::high_resolution_clock::now();
+	nurbs.getPowerBasis();
+	std::cout << "  power basis conversion: " << std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - conversionStart).count() * 1000.0 << " ms" << std::endl;
+
+	TessellatedMesh reference;
+	double referenceTime = 0.0;
+	for (int mode = 0; mode < TESSELLATION_MODE_COUNT; mode++)
+	{
+		TessellatedMesh mesh;
+		auto start = std::chrono::high_resolution_clock::now();
+		tessellateSurface(nurbs, benchmarkU, benchmarkV, TessellationMode(mode), mesh);
+		double seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+		if (mode == TESSELLATION_EXACT)
+		{
+			reference = mesh;
+			referenceTime = seconds;
+		}
+		// deviation from the exact evaluation
+		float maxError = 0.0f;
+		float maxAngle = 0.0f;
+		for (size_t i = 0; i < numSamples; i++)
+		{
+			maxError = std::max(maxError, (mesh.points[i] - reference.points[i]).length());
+			Vec3f n1 = mesh.normals[i];
+			Vec3f n2 = reference.normals[i];
+			if (n1.normalize() && n2.normalize()) maxAngle = std::max(maxAngle, acosf(std::min(n1 * n2, 1.0f)) / M_RadToDeg);
+		}
+		std::cout << "  " << tessellationModeName(TessellationMode(mode)) << ": " << seconds * 1000.0 << " ms, "
+			<< numSamples / seconds << " samples/s, speedup " << referenceTime / seconds
+			<< ", max point error " << maxError << ", max normal error " << maxAngle << " deg" << std::endl;
+	}
+
+	// scattered parameter pairs: batched list evaluation against de Boor per pair
+	std::vector<float> scatteredU(numSamples), scatteredV(numSamples);
+	for (size_t n = 0; n < numSamples; n++)
+	{
+		scatteredU[n] = fmodf(float(n) * 0.6180339887f, 1.0f);
+		scatteredV[n] = fmodf(float(n) * 0.7548776662f, 1.0f);
+	}
+	std::vector<Vec3f> listPoints(numSamples);
+	auto listStart = std::chrono::high_resolution_clock::now();
+	nurbs.evaluateSurfaceAt(scatteredU, scatteredV, SurfaceSampleBuffers(listPoints.data()));
+	double listSeconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - listStart).count();
+	std::vector<Vec4f> pairPoints(numSamples);
+	listStart = std::chrono::high_resolution_clock::now();
+	for (size_t n = 0; n < numSamples; n++)
+	{
+		Vec4f tangentU, tangentV;
+		pairPoints[n] = nurbs.evaluteDeBoor(scatteredU[n], scatteredV[n], tangentU, tangentV);
+	}
+	double pairSeconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - listStart).count();
+	float maxListError = 0.0f;
+	for (size_t n = 0; n < numSamples; n++)
+	{
+		Vec4f point = pairPoints[n].homogenized();
+		maxListError = std::max(maxListError, (listPoints[n] - Vec3f(point.x, point.y, point.z)).length());
+	}
+	std::cout << "  scattered list (" << numSamples << " pairs): de Boor " << pairSeconds * 1000.0 << " ms, evaluateSurfaceAt "
+		<< listSeconds * 1000.0 << " ms, speedup " << pairSeconds / listSeconds << ", max point error " << maxListError << std::endl;
+
+	// the iso curve at v = 0.5: de Boor against Horner evaluation of the power basis
+	NURBSCurve isoCurve = nurbs.extractIsoCurveV(0.5f);
+	std::shared_ptr<const CurvePowerBasis> powerBasis = isoCurve.getPowerBasis();
+	const size_t numCurveSamples = 100000;
+	std::vector<float> T(numCurveSamples);
+	for (size_t i = 0; i < numCurveSamples; i++) T[i] = float(i) / float(numCurveSamples - 1);
+	std::vector<Vec4f> deBoorPoints(numCurveSamples);
+	std::vector<Vec4f> hornerPoints(numCurveSamples);
+	auto start = std::chrono::high_resolution_clock::now();
+	for (size_t i = 0; i < numCurveSamples; i++) deBoorPoints[i] = isoCurve.evaluteDeBoor(T[i]);
+	double deBoorSeconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+	start = std::chrono::high_resolution_clock::now();
+	powerBasis->evaluate(T, hornerPoints.data());
+	double hornerSeconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+	float maxError = 0.0f;
+	for (size_t i = 0; i < numCurveSamples; i++)
+	{
+		Vec4f difference = deBoorPoints[i].homogenized() - hornerPoints[i].homogenized();
+		maxError = std::max(maxError, Vec3f(difference.x, difference.y, difference.z).length());
+	}
+	std::cout << "  iso curve (" << numCurveSamples << " samples): de Boor " << deBoorSeconds * 1000.0 << " ms, power basis "
+		<< hornerSeconds * 1000.0 << " ms, speedup " << deBoorSeconds / hornerSeconds << ", max point error " << maxError << std::endl;
+
+	// closest point projection: points offset along the normal have to project back onto their sample
+	std::vector<float> projectionU = gridParameters(0.05f);
+	std::vector<float> projectionV = gridParameters(0.05f);
+	const size_t numProjections = projectionU.size() * projectionV.size();
+	std::vector<Vec3f> samplePoints(numProjections);
+	std::vector<Vec3f> sampleNormals(numProjections);
+	nurbs.evaluateSurfaceAtGrid(projectionU, projectionV, SurfaceSampleBuffers(samplePoints.data(), nullptr, nullptr, sampleNormals.data()));
+	Vec3f minCorner = samplePoints[0];
+	Vec3f maxCorner = samplePoints[0];
+	for (const Vec3f& point : samplePoints)
+	{
+		for (unsigned int a = 0; a < 3; a++)
+		{
+			minCorner[a] = std::min(minCorner[a], point[a]);
+			maxCorner[a] = std::max(maxCorner[a], point[a]);
+		}
+	}
+	const float offset = 0.01f * (maxCorner - minCorner).length();
+	std::vector<Vec3f> queryPoints;
+	std::vector<Vec3f> footPoints;
+	for (size_t i = 0; i < numProjections; i++)
+	{
+		// degenerate points have no normal
+		if (sampleNormals[i].sqlength() == 0.0f) continue;
+		queryPoints.push_back(samplePoints[i] + sampleNormals[i] * offset);
+		footPoints.push_back(samplePoints[i]);
+	}
+	std::vector<float> projectedU(queryPoints.size());
+	std::vector<float> projectedV(queryPoints.size());
+	std::vector<float> projectedDistances(queryPoints.size());
+	SurfaceProjectionBuffers projection;
+	projection.u = projectedU.data();
+	projection.v = projectedV.data();
+	projection.distance = projectedDistances.data();
+	start = std::chrono::high_resolution_clock::now();
+	SurfaceProjector projector(nurbs);
+	projector.project(queryPoints, projection);
+	double projectionSeconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+	float maxFootError = 0.0f;
+	float maxDistanceError = 0.0f;
+	for (size_t i = 0; i < queryPoints.size(); i++)
+	{
+		Vec3f footPoint;
+		nurbs.evaluateDerivatives(projectedU[i], projectedV[i], 0, &footPoint);
+		maxFootError = std::max(maxFootError, (footPoint - footPoints[i]).length());
+		maxDistanceError = std::max(maxDistanceError, std::fabs(projectedDistances[i] - offset));
+	}
+	std::cout << "  projection (" << queryPoints.size() << " points at distance " << offset << "): " << projectionSeconds * 1000.0
+		<< " ms, max foot point error " << maxFootError << ", max distance error " << maxDistanceError << std::endl;
+
+	// arc length of the rational quarter circle with radius 1 (pi / 2), samples with equal arc length spacing at equal angles
+	const float halfSqrt2 = 0.5f * sqrtf(2.0f);
+	const std::vector<Vec4f> circlePoints = { Vec4f(1.0f, 0.0f, 0.0f, 1.0f), Vec4f(halfSqrt2, halfSqrt2, 0.0f, halfSqrt2), Vec4f(0.0f, 1.0f, 0.0f, 1.0f) };
+	const NURBSCurve quarterCircle(circlePoints, std::vector<float>({ 0.0f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f }), 2);
+	start = std::chrono::high_resolution_clock::now();
+	const float circleLength = quarterCircle.getArcLength();
+	double arcLengthSeconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+	const size_t numArcSamples = 9;
+	std::vector<Vec4f> arcPoints = quarterCircle.sampleByArcLength(numArcSamples).first;
+	float maxAngleError = 0.0f;
+	for (size_t i = 0; i < numArcSamples; i++)
+	{
+		Vec4f point = arcPoints[i].homogenized();
+		float expected = 90.0f * float(i) / float(numArcSamples - 1);
+		maxAngleError = std::max(maxAngleError, std::fabs(atan2f(point.y, point.x) / M_RadToDeg - expected));
+	}
+	std::cout << "  quarter circle: arc length " << circleLength << " (error " << std::fabs(circleLength - 90.0f * M_RadToDeg) << ") in "
+		<< arcLengthSeconds * 1000.0 << " ms, max angle error of " << numArcSamples << " equally spaced samples " << maxAngleError << " deg" << std::endl;
+
+	benchmarkCurveSet();
+}
+
+void benchmarkCurveSet()
+{
+	// rational cubic curves with 8 control points on one clamped uniform knot vector
+	const size_t numCurves = 20000;
+	const unsigned int p = 3;
+	const size_t numControlPoints = 8;
+	std::vector<float> knotVector;
+	for (unsigned int i = 0; i < p; i++) knotVector.push_back(0.0f);
+	for (size_t i = 0; i <= numControlPoints - p; i++) knotVector.push_back(float(i) / float(numControlPoints - p));
+	for (unsigned int i = 0; i < p; i++) knotVector.push_back(1.0f);
+	NURBSCurveSet curveSet(knotVector, p, numControlPoints);
+	std::vector<Vec4f> controlPoints(numControlPoints);
+	for (size_t c = 0; c < numCurves; c++)
+	{
+		for (size_t i = 0; i < numControlPoints; i++)
+		{
+			const float phase = float(c) * 0.37f + float(i);
+			const float w = 1.0f + 0.5f * sinf(phase * 1.3f);
+			controlPoints[i] = Vec4f(float(i) * w, sinf(phase) * w, cosf(phase * 0.7f) * w, w);
+		}
+		curveSet.addCurve(controlPoints);
+	}
+	std::vector<NURBSCurve> curves;
+	curves.reserve(numCurves);
+	for (size_t c = 0; c < numCurves; c++) curves.push_back(curveSet.getCurve(c));
+	std::vector<float> T = gridParameters(0.005f);
+
+	auto start = std::chrono::high_resolution_clock::now();
+	std::vector<CurveSetPoints> setPoints;
+	curveSet.evaluateAt(T, setPoints);
+	double setSeconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+	start = std::chrono::high_resolution_clock::now();
+	std::vector<Vec4f> curvePoints(numCurves * T.size());
+	for (size_t c = 0; c < numCurves; c++)
+		for (size_t j = 0; j < T.size(); j++) curvePoints[c * T.size() + j] = curves[c].evaluteDeBoor(T[j]);
+	double curveSeconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+
+	// points and first derivatives of every curve at every 10th parameter against the single curve evaluation
+	float maxPointError = 0.0f;
+	float maxDerivativeError = 0.0f;
+	CurveSetPoints points, derivatives;
+	Vec3f reference[2];
+	for (size_t j = 0; j < T.size(); j += 10)
+	{
+		curveSet.evaluateAt(T[j], points, &derivatives);
+		for (size_t c = 0; c < numCurves; c++)
+		{
+			curves[c].evaluateDerivatives(T[j], 1, reference);
+			// derivative of the homogenized curve: (A' - w' C) / w
+			const Vec3f point = points.homogenized(c);
+			const Vec3f derivative = (Vec3f(derivatives.x[c], derivatives.y[c], derivatives.z[c]) - point * derivatives.w[c]) / points.w[c];
+			const Vec3f listPoint = setPoints[j].homogenized(c);
+			maxPointError = std::max(maxPointError, std::max((point - reference[0]).length(), (listPoint - reference[0]).length()));
+			maxDerivativeError = std::max(maxDerivativeError, (derivative - reference[1]).length());
+		}
+	}
+	std::cout << "  curve set (" << numCurves << " cubic curves x " << T.size() << " parameters): set " << setSeconds * 1000.0
+		<< " ms, de Boor per curve " << curveSeconds * 1000.0 << " ms, speedup " << curveSeconds / setSeconds
+		<< ", max point error " << maxPointError << ", max derivative error " << maxDerivativeError << std::endl;
+}
+
+void stressConcurrentEvaluation()
+{
+	const NURBS_Surface& nurbs = NURBSs.at(nurbsSelect);
+	if (!nurbs.isValidNURBS()) return;
+	ConcurrencyStressResult result = runConcurrencyStress(nurbs, std::max(std::thread::hardware_concurrency(), 8u), 4);
+	std::cout << std::endl << "Concurrent evaluation: " << result.numThreads << " threads x " << result.samplesPerThread << " samples in " << result.milliseconds << " ms, "
+		<< result.mismatches << " results differ from the single threaded reference" << std::endl;
+}
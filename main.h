@@ -17,6 +17,14 @@
 #include "Vec4.h"
 #include "Vec3.h"
 #include "NURBS_Surface.h"
+#include "CurvatureAnalysis.h"
+#include "Tessellation.h"
+#include "RenderStatistics.h"
+#include "AsyncTessellation.h"
+#include "TessellationCache.h"
+#include "TessellationDiskCache.h"
+#include "SceneTessellation.h"
+#include "MeshSnapshot.h"
 
 // ===================
 // === GLOBAL DATA ===
@@ -35,14 +43,32 @@ unsigned int nrPoints;
 
 // TODO: define global variables here to present the exercises
 // ===========================================================
-std::vector<Vec4f> points;
-std::vector<Vec3f> normals;
-size_t numPointsU;
-size_t numPointsV;
+MeshPublisher meshPublisher;		// snapshot of the current tessellation (mesh, indexed mesh, curvature colors), drawn every frame
 
 std::vector<float> resolutionU;
 std::vector<float> resolutionV;
 
+CurvatureType curvatureDisplay = CURVATURE_NONE;
+TessellationMode tessellationMode = TESSELLATION_EXACT;
+
+bool enableHUD = false;				// statistics overlay
+FrameTimeWindow frameTimes;			// cpu time of the last frames
+double tessellationMilliseconds = 0.0;	// duration of the last tessellation
+size_t tessellationSamples = 0;
+
+AsyncTessellator tessellator;		// background tessellation of the selected surface
+bool tessellationPolling = false;	// a timer for pollTessellation is armed
+const unsigned int TESSELLATION_POLL_MS = 30;
+TessellationCache tessellationCache(256 * 1024 * 1024);	// finished tessellations by content hash, 256 MB budget
+TessellationDiskCache tessellationDiskCache("tessellation_cache", 512 * 1024 * 1024);	// persistent cache, 512 MB cap
+TessellationKey pendingTessellationKey = 0;				// key of the running job
+
+const double CAMERA_FIELD_OF_VIEW = 65.0;	// vertical, degrees
+const float CURVE_PIXEL_TOLERANCE = 0.5f;	// chord deviation of the drawn curves in pixels
+
+bool sceneMode = false;												// draw all surfaces instead of the selected one
+std::vector<std::shared_ptr<const TessellationResult>> sceneMeshes;	// tessellation of every surface in scene mode (nullptr: invalid surface)
+
 
 // ===========================================================
 
@@ -68,6 +94,22 @@ void createNURBSs();
 
 void calculatePoints();
 
+void pollTessellation(int value);
+
+// publish a snapshot of result as the drawn mesh
+void applyTessellation(const std::shared_ptr<const TessellationResult>& result);
+
+// publish a snapshot of the current tessellation with the colors of the displayed curvature
+void updateCurvatureColors();
+
+void calculateScene();
+
+// returns the cached tessellation of the surface (memory cache first, then disk cache) or nullptr
+std::shared_ptr<const TessellationResult> findCachedTessellation(const TessellationKey key);
+
+// add a finished tessellation to the memory and disk cache
+void cacheTessellation(const TessellationKey key, const std::shared_ptr<const TessellationResult>& result);
+
 void reshape(GLint width, GLint height);
 
 // =================
@@ -78,6 +120,11 @@ void drawCS();
 
 void drawObjects();
 
+void drawHUD();
+
+// set the curve sampling tolerance to CURVE_PIXEL_TOLERANCE pixels at the distance of the scene origin
+void updateCurveSamplingTolerance();
+
 void renderScene(void);
 
 // =================
@@ -95,3 +142,15 @@ void mouseMoved(int x, int y);
 // ===============
 
 void coutHelp();
+
+// print the welding, vertex cache and memory statistics of the indexed mesh
+void coutIndexedMesh();
+
+void benchmarkTessellation();
+
+// time a NURBSCurveSet against evaluating its curves one by one and compare the results (part of benchmarkTessellation)
+void benchmarkCurveSet();
+
+// evaluate the current surface from many threads at once and compare with a single threaded reference
+// (build with ENABLE_THREAD_SANITIZER to check for data races)
+void stressConcurrentEvaluation();